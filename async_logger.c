@@ -0,0 +1,224 @@
+/***
+ * Asynchronous lock-free logger
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "async_logger.h"
+
+#define LOG_IDLE_SLEEP_NANOSECONDS 200000
+
+/***
+ * The ring the calling thread logs into and the logger it belongs to
+ */
+static _Thread_local async_logger_t *thread_logger;
+static _Thread_local log_ring_t *thread_ring;
+
+/***
+ * Write a whole buffer, retrying after partial writes and interruptions
+ * @param fd the file descriptor to write to
+ * @param data the buffer
+ * @param length the number of bytes to write
+ */
+static void write_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += written;
+        length -= (size_t) written;
+    }
+}
+
+/***
+ * Move the pending messages of every ring into the write buffer, writing it out whenever it fills up
+ * @param logger the logger
+ * @param buffer the write buffer
+ * @param used the number of bytes already in the write buffer
+ * @return the number of bytes in the write buffer afterwards
+ */
+static size_t drain(async_logger_t *logger, char *buffer, size_t used) {
+    int ring_index, ring_count = atomic_load_explicit(&logger->ring_count, memory_order_acquire);
+
+    for (ring_index = 0; ring_index < ring_count; ring_index++) {
+        log_ring_t *ring = logger->rings[ring_index];
+        size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        for (; head != tail; head++) {
+            log_record_t *record = &ring->records[head % LOG_RING_RECORDS];
+            if (used + record->length > LOG_WRITE_BUFFER_SIZE) {
+                write_all(logger->fd, buffer, used);
+                used = 0;
+            }
+            memcpy(buffer + used, record->text, record->length);
+            used += record->length;
+        }
+
+        // hand the drained records back to the logging thread
+        atomic_store_explicit(&ring->head, head, memory_order_release);
+    }
+
+    return used;
+}
+
+/***
+ * The writer thread, drains the rings until the logger stops and the rings are empty
+ * @param argument the logger
+ * @return NULL
+ */
+static void *writer(void *argument) {
+    async_logger_t *logger = (async_logger_t *) argument;
+    struct timespec idle = {0, LOG_IDLE_SLEEP_NANOSECONDS};
+    char *buffer = (char *) malloc(LOG_WRITE_BUFFER_SIZE);
+    size_t used;
+    int stopping;
+
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    do {
+        // read the flag before draining so that messages logged before the stop request are never left behind
+        stopping = atomic_load(&logger->stopping);
+        used = drain(logger, buffer, 0);
+        if (used > 0) {
+            write_all(logger->fd, buffer, used);
+        } else if (!stopping) {
+            nanosleep(&idle, NULL);
+        }
+    } while (!stopping);
+
+    free(buffer);
+    return NULL;
+}
+
+int async_logger_init(async_logger_t *logger, int fd, int drop_when_full) {
+    int error_code;
+
+    logger->fd = fd;
+    logger->drop_when_full = drop_when_full;
+    atomic_init(&logger->stopping, 0);
+    atomic_init(&logger->ring_count, 0);
+    atomic_init(&logger->dropped, 0);
+
+    error_code = pthread_mutex_init(&logger->registration_lock, NULL);
+    if (error_code != 0) {
+        return error_code;
+    }
+    return pthread_create(&logger->writer, NULL, writer, logger);
+}
+
+int async_logger_destroy(async_logger_t *logger) {
+    int error_code, ring_index, ring_count;
+    unsigned long long dropped;
+    char message[LOG_RECORD_SIZE];
+
+    atomic_store(&logger->stopping, 1);
+    error_code = pthread_join(logger->writer, NULL);
+    if (error_code != 0) {
+        return error_code;
+    }
+
+    dropped = atomic_load(&logger->dropped);
+    if (dropped > 0) {
+        int length = snprintf(message, sizeof(message), "Logger dropped %llu messages\n", dropped);
+        write_all(logger->fd, message, (size_t) length);
+    }
+
+    ring_count = atomic_load(&logger->ring_count);
+    for (ring_index = 0; ring_index < ring_count; ring_index++) {
+        free(logger->rings[ring_index]);
+    }
+    return pthread_mutex_destroy(&logger->registration_lock);
+}
+
+/***
+ * Allocate a ring for the calling thread and publish it to the writer
+ * @param logger the logger
+ * @return the ring, NULL if the logger has no room for another thread
+ */
+static log_ring_t *register_thread(async_logger_t *logger) {
+    int ring_index;
+    log_ring_t *ring = (log_ring_t *) aligned_alloc(CACHE_LINE_SIZE, sizeof(log_ring_t));
+
+    if (ring == NULL) {
+        return NULL;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+
+    // registration happens once per thread, so a lock keeps it simple; the writer only reads entries below the
+    // published count
+    pthread_mutex_lock(&logger->registration_lock);
+    ring_index = atomic_load_explicit(&logger->ring_count, memory_order_relaxed);
+    if (ring_index >= LOG_MAX_THREADS) {
+        pthread_mutex_unlock(&logger->registration_lock);
+        free(ring);
+        return NULL;
+    }
+    logger->rings[ring_index] = ring;
+    atomic_store_explicit(&logger->ring_count, ring_index + 1, memory_order_release);
+    pthread_mutex_unlock(&logger->registration_lock);
+
+    return ring;
+}
+
+void async_logger_log(async_logger_t *logger, const char *format, ...) {
+    va_list arguments;
+
+    va_start(arguments, format);
+    async_logger_vlog(logger, format, arguments);
+    va_end(arguments);
+}
+
+void async_logger_vlog(async_logger_t *logger, const char *format, va_list arguments) {
+    log_ring_t *ring;
+    log_record_t *record;
+    size_t tail;
+    int length;
+
+    if (thread_logger != logger) {
+        thread_ring = register_thread(logger);
+        thread_logger = logger;
+    }
+    ring = thread_ring;
+    if (ring == NULL) {
+        atomic_fetch_add_explicit(&logger->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    // wait for the writer or drop the message when the ring is full
+    tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == LOG_RING_RECORDS) {
+        if (logger->drop_when_full) {
+            atomic_fetch_add_explicit(&logger->dropped, 1, memory_order_relaxed);
+            return;
+        }
+        sched_yield();
+    }
+
+    record = &ring->records[tail % LOG_RING_RECORDS];
+    length = vsnprintf(record->text, sizeof(record->text), format, arguments);
+    if (length < 0) {
+        length = 0;
+    } else if ((size_t) length >= sizeof(record->text)) {
+        length = sizeof(record->text) - 1;
+    }
+    record->length = (unsigned short) length;
+
+    // publish the message to the writer
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
@@ -0,0 +1,92 @@
+/***
+ * Asynchronous lock-free logger
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Every thread that logs formats its messages into a single-producer/single-consumer ring of its own, which takes
+ * no lock and makes no system call. A background writer thread drains the rings of all threads into a large
+ * buffer and hands it to the kernel with one write per batch. Messages of one thread keep their order, messages
+ * of different threads are interleaved in the order the writer finds them.
+ *
+ * When a thread's ring is full the logger either waits for the writer to make room or drops the message and
+ * counts it, as chosen when the logger is initialized.
+ */
+
+#ifndef BOUNDED_BUFFER_ASYNC_LOGGER_H
+#define BOUNDED_BUFFER_ASYNC_LOGGER_H
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "cache_line.h"
+
+#define LOG_RECORD_SIZE 128
+#define LOG_RING_RECORDS 1024
+#define LOG_MAX_THREADS 64
+#define LOG_WRITE_BUFFER_SIZE 65536
+
+/***
+ * A formatted message
+ */
+typedef struct log_record {
+    unsigned short length;
+    char text[LOG_RECORD_SIZE - sizeof(unsigned short)];
+} log_record_t;
+
+/***
+ * The ring of one logging thread, the thread owns tail and the writer owns head
+ */
+typedef struct log_ring {
+    CACHE_LINE_ALIGNED atomic_size_t tail;
+    CACHE_LINE_ALIGNED atomic_size_t head;
+    log_record_t records[LOG_RING_RECORDS];
+} log_ring_t;
+
+/***
+ * The logger
+ */
+typedef struct async_logger {
+    int fd;
+    int drop_when_full;
+    atomic_int stopping;
+    atomic_int ring_count;
+    atomic_ullong dropped;
+    log_ring_t *rings[LOG_MAX_THREADS];
+    pthread_mutex_t registration_lock;
+    pthread_t writer;
+} async_logger_t;
+
+/***
+ * Initialize the logger and start its writer thread
+ * @param logger the logger to initialize
+ * @param fd the file descriptor the messages are written to
+ * @param drop_when_full set to drop messages instead of waiting when a thread's ring is full
+ * @return 0 on success, an error number otherwise
+ */
+int async_logger_init(async_logger_t *logger, int fd, int drop_when_full);
+
+/***
+ * Write every pending message, stop the writer thread and release the rings
+ * @param logger the logger to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int async_logger_destroy(async_logger_t *logger);
+
+/***
+ * Format a message like printf and queue it for the writer, messages longer than a record are truncated
+ * @param logger the logger
+ * @param format the printf format
+ */
+void async_logger_log(async_logger_t *logger, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/***
+ * Format a message like vprintf and queue it for the writer, messages longer than a record are truncated
+ * @param logger the logger
+ * @param format the printf format
+ * @param arguments the arguments of the format
+ */
+void async_logger_vlog(async_logger_t *logger, const char *format, va_list arguments);
+
+#endif //BOUNDED_BUFFER_ASYNC_LOGGER_H
@@ -0,0 +1,840 @@
+/***
+ * Throughput and latency benchmark of the bounded buffer implementations
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Sweeps synchronization mode, buffer capacity, producer/consumer counts, payload size and wait strategy, moves a
+ * fixed number of items through every combination and prints one JSON object per run with the throughput and the
+ * 50th, 99th and 99.9th percentile of the handoff latency (the time from just before the push to just after the
+ * pop).
+ *
+ * Every run can also produce each item with one of the factorial kernels before pushing it. The cost of the kernel
+ * on its own is measured once on a single thread and reported next to every run that uses it, so the produce cost
+ * and the queue cost can be told apart.
+ *
+ * Without a payload the item itself is the timestamp of the push. With a payload the producer takes a record from
+ * a pool, fills it, stamps it and passes the index of the record through the buffer; the consumer reads the whole
+ * record and returns it to the pool through a second queue.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "buffer_memory.h"
+#include "factorial.h"
+#include "file_ring.h"
+#include "futex_semaphore.h"
+#include "mpmc_queue.h"
+#include "ring_math.h"
+#include "sharded_queue.h"
+#include "shm_ring.h"
+#include "spsc_ring.h"
+#include "wait_strategy.h"
+
+#define MAX_SWEEP_VALUES 16
+#define DEFAULT_ITEM_COUNT 200000ULL
+#define PRODUCE_ARGUMENT_RANGE 100
+
+/***
+ * A buffer implementation under test
+ */
+typedef struct bench_mode {
+    const char *name;
+    int uses_wait_strategy;
+    int single_producer_consumer;
+    int (*init)(size_t capacity);
+    void (*destroy)(void);
+    void (*push)(long double item);
+    long double (*pop)(void);
+} bench_mode_t;
+
+/***
+ * A kernel that produces items, cost caches the nanoseconds per item it takes on its own once measured
+ */
+typedef struct produce_kernel {
+    const char *name;
+    long double (*function)(unsigned int number);
+    double cost;
+} produce_kernel_t;
+
+/***
+ * A record of the payload pool
+ */
+typedef struct payload_record {
+    uint64_t timestamp;
+    unsigned char bytes[];
+} payload_record_t;
+
+/***
+ * The state of the semaphore and futex modes, a ring guarded by a mutex and a pair of counting semaphores
+ */
+long double *locked_buffer;
+size_t locked_mask, locked_head, locked_tail;
+pthread_mutex_t locked_lock;
+sem_t empty_semaphore, full_semaphore;
+futex_semaphore_t empty_futex_semaphore, full_futex_semaphore;
+
+/***
+ * The state of the lock-free modes
+ */
+spsc_ring_t ring;
+mpmc_queue_t queue;
+shm_ring_t shared_ring;
+char shared_ring_name[64];
+
+/***
+ * The state of the sharded modes, threads take a lane or a starting lane in the order of their first call
+ */
+sharded_queue_t sharded_queue;
+atomic_int next_producer_lane, next_consumer_lane;
+
+/***
+ * The state of the file modes, the file lives in the working directory so that the sync policies write back to a
+ * real file system
+ */
+file_ring_t persistent_ring;
+char persistent_ring_path[64];
+
+/***
+ * The configuration of the current run
+ */
+bench_mode_t *mode;
+int producer_count, consumer_count;
+size_t payload_size;
+produce_kernel_t *kernel;
+unsigned long long item_count;
+
+/***
+ * The payload pool and the queue that returns free records to the producers
+ */
+unsigned char *pool;
+size_t record_size;
+mpmc_queue_t free_records;
+
+/***
+ * The number of items claimed by consumers and the latency samples of each consumer
+ */
+atomic_ullong items_claimed;
+uint64_t **latencies;
+unsigned long long *latency_counts;
+
+/***
+ * Read the monotonic clock
+ * @return the current time in nanoseconds
+ */
+static uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ULL + (uint64_t) time.tv_nsec;
+}
+
+/***
+ * Initialize the ring shared by the semaphore and futex modes
+ * @param capacity the maximum number of items the ring can hold
+ * @return 0 on success, an error number otherwise
+ */
+static int locked_ring_init(size_t capacity) {
+    int error_code;
+
+    locked_mask = round_up_power_of_two(capacity) - 1;
+    error_code = buffer_memory_allocate((void **) &locked_buffer, sizeof(long double) * (locked_mask + 1));
+    if (error_code != 0) {
+        return error_code;
+    }
+    locked_head = 0;
+    locked_tail = 0;
+    return pthread_mutex_init(&locked_lock, NULL);
+}
+
+/***
+ * Release the ring shared by the semaphore and futex modes
+ */
+static void locked_ring_destroy(void) {
+    pthread_mutex_destroy(&locked_lock);
+    buffer_memory_free(locked_buffer, sizeof(long double) * (locked_mask + 1));
+}
+
+/***
+ * Append an item to the locked ring, the caller has reserved a slot
+ * @param item the item to append
+ */
+static void locked_ring_put(long double item) {
+    pthread_mutex_lock(&locked_lock);
+    locked_buffer[locked_tail++ & locked_mask] = item;
+    pthread_mutex_unlock(&locked_lock);
+}
+
+/***
+ * Remove the oldest item from the locked ring, the caller has reserved an item
+ * @return the removed item
+ */
+static long double locked_ring_take(void) {
+    long double item;
+    pthread_mutex_lock(&locked_lock);
+    item = locked_buffer[locked_head++ & locked_mask];
+    pthread_mutex_unlock(&locked_lock);
+    return item;
+}
+
+static int semaphore_init(size_t capacity) {
+    int error_code = locked_ring_init(capacity);
+    if (error_code != 0) {
+        return error_code;
+    }
+    if (sem_init(&full_semaphore, 0, 0) != 0 || sem_init(&empty_semaphore, 0, (unsigned int) capacity) != 0) {
+        return errno;
+    }
+    return 0;
+}
+
+static void semaphore_destroy(void) {
+    sem_destroy(&full_semaphore);
+    sem_destroy(&empty_semaphore);
+    locked_ring_destroy();
+}
+
+static void semaphore_push(long double item) {
+    sem_wait(&empty_semaphore);
+    locked_ring_put(item);
+    sem_post(&full_semaphore);
+}
+
+static long double semaphore_pop(void) {
+    long double item;
+    sem_wait(&full_semaphore);
+    item = locked_ring_take();
+    sem_post(&empty_semaphore);
+    return item;
+}
+
+static int futex_init(size_t capacity) {
+    int error_code = locked_ring_init(capacity);
+    if (error_code != 0) {
+        return error_code;
+    }
+    error_code = futex_semaphore_init(&full_futex_semaphore, 0);
+    if (error_code != 0) {
+        return error_code;
+    }
+    return futex_semaphore_init(&empty_futex_semaphore, (int) capacity);
+}
+
+static void futex_destroy(void) {
+    futex_semaphore_destroy(&full_futex_semaphore);
+    futex_semaphore_destroy(&empty_futex_semaphore);
+    locked_ring_destroy();
+}
+
+static void futex_push(long double item) {
+    futex_semaphore_wait(&empty_futex_semaphore);
+    locked_ring_put(item);
+    futex_semaphore_post(&full_futex_semaphore);
+}
+
+static long double futex_pop(void) {
+    long double item;
+    futex_semaphore_wait(&full_futex_semaphore);
+    item = locked_ring_take();
+    futex_semaphore_post(&empty_futex_semaphore);
+    return item;
+}
+
+static int spsc_init(size_t capacity) {
+    return spsc_ring_init(&ring, capacity);
+}
+
+static void spsc_destroy(void) {
+    spsc_ring_destroy(&ring);
+}
+
+static void spsc_push(long double item) {
+    spsc_ring_push(&ring, item);
+}
+
+static long double spsc_pop(void) {
+    return spsc_ring_pop(&ring);
+}
+
+static int mpmc_init(size_t capacity) {
+    return mpmc_queue_init(&queue, capacity);
+}
+
+static void mpmc_destroy(void) {
+    mpmc_queue_destroy(&queue);
+}
+
+static void mpmc_push(long double item) {
+    mpmc_queue_push(&queue, item);
+}
+
+static long double mpmc_pop(void) {
+    return mpmc_queue_pop(&queue);
+}
+
+/***
+ * Create the queue of a sharded mode, the capacity is split over the lanes so that the queue as a whole holds as many
+ * items as the other modes
+ * @param capacity the maximum number of items the queue can hold
+ * @param policy how consumers move between lanes
+ * @return 0 on success, an error number otherwise
+ */
+static int sharded_init(size_t capacity, sharded_queue_policy_t policy) {
+    size_t lane_capacity = capacity / (size_t) producer_count;
+
+    atomic_store(&next_producer_lane, 0);
+    atomic_store(&next_consumer_lane, 0);
+    return sharded_queue_init(&sharded_queue, producer_count, (lane_capacity > 0) ? lane_capacity : 1,
+                              consumer_count, policy);
+}
+
+static int sharded_round_robin_init(size_t capacity) {
+    return sharded_init(capacity, SHARDED_QUEUE_ROUND_ROBIN);
+}
+
+static int sharded_drain_init(size_t capacity) {
+    return sharded_init(capacity, SHARDED_QUEUE_DRAIN);
+}
+
+static void sharded_destroy(void) {
+    sharded_queue_destroy(&sharded_queue);
+}
+
+static void sharded_push(long double item) {
+    static _Thread_local int lane = -1;
+
+    if (lane < 0) {
+        lane = atomic_fetch_add(&next_producer_lane, 1);
+    }
+    sharded_queue_push(&sharded_queue, lane, item);
+}
+
+static long double sharded_pop(void) {
+    static _Thread_local sharded_queue_cursor_t cursor = {-1};
+
+    if (cursor.lane < 0) {
+        sharded_queue_cursor_init(&sharded_queue, &cursor, atomic_fetch_add(&next_consumer_lane, 1));
+    }
+    return sharded_queue_pop(&sharded_queue, &cursor);
+}
+
+static int shm_init(size_t capacity) {
+    snprintf(shared_ring_name, sizeof(shared_ring_name), "/bb_bench_%d", (int) getpid());
+    return shm_ring_create(&shared_ring, shared_ring_name, capacity);
+}
+
+static void shm_destroy(void) {
+    shm_ring_close(&shared_ring);
+    shm_ring_unlink(shared_ring_name);
+}
+
+static void shm_push(long double item) {
+    shm_ring_push(&shared_ring, item);
+}
+
+static long double shm_pop(void) {
+    return shm_ring_pop(&shared_ring);
+}
+
+/***
+ * Create the file of a file mode
+ * @param capacity the maximum number of items the ring can hold
+ * @param sync when the producer commits items to the file
+ * @param sync_period the number of items or nanoseconds of the sync policy
+ * @return 0 on success, an error number otherwise
+ */
+static int file_init(size_t capacity, file_ring_sync_t sync, uint64_t sync_period) {
+    snprintf(persistent_ring_path, sizeof(persistent_ring_path), "bb_bench_%d.ring", (int) getpid());
+    unlink(persistent_ring_path);
+    return file_ring_open(&persistent_ring, persistent_ring_path, capacity, sync, sync_period);
+}
+
+static int file_none_init(size_t capacity) {
+    return file_init(capacity, FILE_RING_SYNC_NONE, 0);
+}
+
+static int file_item_init(size_t capacity) {
+    return file_init(capacity, FILE_RING_SYNC_ITEMS, 1);
+}
+
+static int file_batch_init(size_t capacity) {
+    return file_init(capacity, FILE_RING_SYNC_ITEMS, 64);
+}
+
+static int file_interval_init(size_t capacity) {
+    return file_init(capacity, FILE_RING_SYNC_INTERVAL, 1000000);
+}
+
+static void file_destroy(void) {
+    file_ring_close(&persistent_ring);
+    unlink(persistent_ring_path);
+}
+
+static void file_push(long double item) {
+    file_ring_push(&persistent_ring, item);
+}
+
+static long double file_pop(void) {
+    return file_ring_pop(&persistent_ring);
+}
+
+/***
+ * The implementations that can be benchmarked, the file modes differ in durability: file-none survives a crash of
+ * the process, file-item makes every item durable, file-batch every 64 items and file-interval every millisecond
+ */
+bench_mode_t modes[] = {
+        {"semaphore",     0, 0, semaphore_init,           semaphore_destroy, semaphore_push, semaphore_pop},
+        {"futex",         1, 0, futex_init,               futex_destroy,     futex_push,     futex_pop},
+        {"spsc",          1, 1, spsc_init,                spsc_destroy,      spsc_push,      spsc_pop},
+        {"mpmc",          1, 0, mpmc_init,                mpmc_destroy,      mpmc_push,      mpmc_pop},
+        {"shm",           1, 1, shm_init,                 shm_destroy,       shm_push,       shm_pop},
+        {"file-none",     1, 1, file_none_init,           file_destroy,      file_push,      file_pop},
+        {"file-item",     1, 1, file_item_init,           file_destroy,      file_push,      file_pop},
+        {"file-batch",    1, 1, file_batch_init,          file_destroy,      file_push,      file_pop},
+        {"file-interval", 1, 1, file_interval_init,       file_destroy,      file_push,      file_pop},
+        {"sharded",       1, 0, sharded_round_robin_init, sharded_destroy,   sharded_push,   sharded_pop},
+        {"sharded-drain", 1, 0, sharded_drain_init,       sharded_destroy,   sharded_push,   sharded_pop},
+};
+
+/***
+ * The kernels that can produce items, the argument of the n-th item is n modulo PRODUCE_ARGUMENT_RANGE like in the
+ * demo
+ */
+produce_kernel_t kernels[] = {
+        {"none",      NULL,                0},
+        {"recursive", factorial_recursive, -1},
+        {"iterative", factorial_iterative, -1},
+        {"table",     factorial,           -1},
+};
+#define KERNEL_COUNT ((int) (sizeof(kernels) / sizeof(kernels[0])))
+
+/***
+ * Sink for the produced items so the compiler cannot drop the kernels
+ */
+volatile long double produced;
+
+/***
+ * Measure the cost of the current kernel on its own, once per kernel
+ * @return the nanoseconds per item
+ */
+static double produce_cost(void) {
+    unsigned long long item_index;
+    long double sum = 0;
+    uint64_t start;
+
+    if (kernel->cost < 0) {
+        start = now_ns();
+        for (item_index = 0; item_index < item_count; item_index++) {
+            sum += kernel->function((unsigned int) (item_index % PRODUCE_ARGUMENT_RANGE));
+        }
+        kernel->cost = (double) (now_ns() - start) / (double) item_count;
+        produced = sum;
+    }
+    return kernel->cost;
+}
+
+/***
+ * Get a record of the payload pool
+ * @param index the index of the record
+ * @return the record
+ */
+static payload_record_t *record_at(size_t index) {
+    return (payload_record_t *) (pool + index * record_size);
+}
+
+/***
+ * The producer function
+ * @param id the index of the producer thread
+ * @return NULL
+ */
+void *producer(void *id) {
+    int producer_id = (int) (intptr_t) id;
+    unsigned long long item_index;
+    unsigned long long items = item_count / producer_count + (producer_id < (int) (item_count % producer_count));
+    long double sum = 0;
+
+    for (item_index = 0; item_index < items; item_index++) {
+        if (kernel->function != NULL) {
+            sum += kernel->function((unsigned int) (item_index % PRODUCE_ARGUMENT_RANGE));
+        }
+
+        if (payload_size == 0) {
+            mode->push((long double) now_ns());
+        } else {
+            // take a free record, fill it and pass its index through the buffer
+            size_t index = (size_t) mpmc_queue_pop(&free_records);
+            payload_record_t *record = record_at(index);
+            memset(record->bytes, (int) item_index, payload_size);
+            record->timestamp = now_ns();
+            mode->push((long double) index);
+        }
+    }
+
+    produced = sum;
+    return NULL;
+}
+
+/***
+ * The consumer function
+ * @param id the index of the consumer thread
+ * @return NULL
+ */
+void *consumer(void *id) {
+    int consumer_id = (int) (intptr_t) id;
+    uint64_t *samples = latencies[consumer_id];
+    unsigned long long count = 0;
+    volatile unsigned char checksum = 0;
+
+    while (atomic_fetch_add(&items_claimed, 1) < item_count) {
+        long double item = mode->pop();
+        uint64_t received = now_ns();
+
+        if (payload_size == 0) {
+            samples[count++] = received - (uint64_t) item;
+        } else {
+            // read the whole record before handing it back to the producers
+            size_t index = (size_t) item, byte;
+            payload_record_t *record = record_at(index);
+            unsigned char sum = 0;
+            samples[count++] = received - record->timestamp;
+            for (byte = 0; byte < payload_size; byte++) {
+                sum ^= record->bytes[byte];
+            }
+            checksum ^= sum;
+            mpmc_queue_push(&free_records, (long double) index);
+        }
+    }
+
+    latency_counts[consumer_id] = count;
+    return NULL;
+}
+
+/***
+ * Compare two latency samples for sorting
+ * @param first the first sample
+ * @param second the second sample
+ * @return negative, zero or positive like strcmp
+ */
+static int compare_samples(const void *first, const void *second) {
+    uint64_t a = *(const uint64_t *) first, b = *(const uint64_t *) second;
+    return (a > b) - (a < b);
+}
+
+/***
+ * Get a percentile of sorted samples
+ * @param samples the sorted samples
+ * @param count the number of samples
+ * @param percentile the percentile, between 0 and 100
+ * @return the sample at the percentile
+ */
+static uint64_t percentile_of(const uint64_t *samples, unsigned long long count, double percentile) {
+    unsigned long long rank = (unsigned long long) (percentile / 100.0 * (double) (count - 1) + 0.5);
+    return samples[rank];
+}
+
+/***
+ * Run one combination of the sweep and print its result
+ * @param capacity the capacity of the buffer
+ * @param spin_limit the spin limit of the wait strategy
+ * @param yield_limit the yield limit of the wait strategy
+ * @param first set for the first result so that the separating comma is left out
+ */
+static void run(size_t capacity, unsigned int spin_limit, unsigned int yield_limit, int first) {
+    int error_code, thread_index;
+    unsigned long long sample_count = 0, pool_records = 0, index;
+    pthread_t *threads;
+    uint64_t *merged, start, end;
+    double seconds;
+
+    wait_strategy_configure(spin_limit, yield_limit);
+
+    error_code = mode->init(capacity);
+    if (error_code != 0) {
+        fprintf(stderr, "Could not initialize %s buffer, error code = %d\n", mode->name, error_code);
+        exit(EXIT_FAILURE);
+    }
+
+    // a pool larger than the buffer by one record per thread never runs dry while every thread holds a record
+    if (payload_size > 0) {
+        record_size = (sizeof(payload_record_t) + payload_size + 15) & ~(size_t) 15;
+        pool_records = capacity + producer_count + consumer_count;
+        pool = (unsigned char *) malloc(record_size * pool_records);
+        error_code = (pool == NULL) ? ENOMEM : mpmc_queue_init(&free_records, pool_records);
+        if (error_code != 0) {
+            fprintf(stderr, "Could not initialize payload pool, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        for (index = 0; index < pool_records; index++) {
+            mpmc_queue_push(&free_records, (long double) index);
+        }
+    }
+
+    threads = (pthread_t *) malloc(sizeof(pthread_t) * (producer_count + consumer_count));
+    latencies = (uint64_t **) malloc(sizeof(uint64_t *) * consumer_count);
+    latency_counts = (unsigned long long *) calloc(consumer_count, sizeof(unsigned long long));
+    if (threads == NULL || latencies == NULL || latency_counts == NULL) {
+        fprintf(stderr, "Could not allocate memory for threads\n");
+        exit(EXIT_FAILURE);
+    }
+    for (thread_index = 0; thread_index < consumer_count; thread_index++) {
+        latencies[thread_index] = (uint64_t *) malloc(sizeof(uint64_t) * item_count);
+        if (latencies[thread_index] == NULL) {
+            fprintf(stderr, "Could not allocate memory for latency samples\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    atomic_init(&items_claimed, 0);
+
+    start = now_ns();
+    for (thread_index = 0; thread_index < consumer_count; thread_index++) {
+        error_code = pthread_create(&threads[producer_count + thread_index], NULL, consumer,
+                                    (void *) (intptr_t) thread_index);
+        if (error_code != 0) {
+            fprintf(stderr, "Could not create consumer thread, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (thread_index = 0; thread_index < producer_count; thread_index++) {
+        error_code = pthread_create(&threads[thread_index], NULL, producer, (void *) (intptr_t) thread_index);
+        if (error_code != 0) {
+            fprintf(stderr, "Could not create producer thread, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (thread_index = 0; thread_index < producer_count + consumer_count; thread_index++) {
+        pthread_join(threads[thread_index], NULL);
+    }
+    end = now_ns();
+    seconds = (double) (end - start) / 1e9;
+
+    // merge the samples of every consumer and sort them for the percentiles
+    merged = (uint64_t *) malloc(sizeof(uint64_t) * item_count);
+    if (merged == NULL) {
+        fprintf(stderr, "Could not allocate memory for latency samples\n");
+        exit(EXIT_FAILURE);
+    }
+    for (thread_index = 0; thread_index < consumer_count; thread_index++) {
+        memcpy(merged + sample_count, latencies[thread_index], sizeof(uint64_t) * latency_counts[thread_index]);
+        sample_count += latency_counts[thread_index];
+        free(latencies[thread_index]);
+    }
+    qsort(merged, sample_count, sizeof(uint64_t), compare_samples);
+
+    printf("%s  {\"mode\": \"%s\", \"capacity\": %zu, \"producers\": %d, \"consumers\": %d, \"payload_bytes\": %zu, ",
+           first ? "" : ",\n", mode->name, capacity, producer_count, consumer_count, payload_size);
+    if (mode->uses_wait_strategy) {
+        printf("\"spin_limit\": %u, \"yield_limit\": %u, ", spin_limit, yield_limit);
+    } else {
+        printf("\"spin_limit\": null, \"yield_limit\": null, ");
+    }
+    printf("\"produce\": \"%s\", \"produce_ns_per_item\": %.2f, ", kernel->name, produce_cost());
+    printf("\"items\": %llu, \"seconds\": %.6f, \"items_per_second\": %.0f, "
+           "\"latency_ns\": {\"p50\": %llu, \"p99\": %llu, \"p99.9\": %llu}}",
+           item_count, seconds, (double) item_count / seconds,
+           (unsigned long long) percentile_of(merged, sample_count, 50.0),
+           (unsigned long long) percentile_of(merged, sample_count, 99.0),
+           (unsigned long long) percentile_of(merged, sample_count, 99.9));
+    fflush(stdout);
+
+    free(merged);
+    free(latencies);
+    free(latency_counts);
+    free(threads);
+    if (payload_size > 0) {
+        mpmc_queue_destroy(&free_records);
+        free(pool);
+    }
+    mode->destroy();
+}
+
+/***
+ * Print the command line usage
+ * @param program the name of the executable
+ */
+void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-m modes] [-s capacities] [-t threads] [-P payloads] [-w strategies] [-f kernels]"
+                    " [-M memory] [-n items]\n", program);
+    fprintf(stderr, "  -m  comma separated modes out of semaphore,futex,spsc,mpmc,shm,file-none,file-item,"
+                    "file-batch,file-interval,sharded,sharded-drain (default all)\n");
+    fprintf(stderr, "  -s  comma separated buffer capacities (default 16,128,1024)\n");
+    fprintf(stderr, "  -t  comma separated producer x consumer counts (default 1x1,2x2)\n");
+    fprintf(stderr, "  -P  comma separated payload sizes in bytes (default 0,64,1024)\n");
+    fprintf(stderr, "  -w  colon separated spin,yield wait strategies (default 256,16:0,0)\n");
+    fprintf(stderr, "  -f  comma separated produce kernels out of none,recursive,iterative,table (default none)\n");
+    fprintf(stderr, "  -M  comma separated buffer memory options out of hugetlb, thp, prefault and node=N\n");
+    fprintf(stderr, "  -n  number of items per run (default %llu)\n", DEFAULT_ITEM_COUNT);
+}
+
+/***
+ * Parse a comma separated list of sizes
+ * @param list the list to parse
+ * @param values location where the values are stored
+ * @return the number of values
+ */
+static int parse_sizes(char *list, size_t *values) {
+    int count = 0;
+    char *token, *state;
+
+    for (token = strtok_r(list, ",", &state); token != NULL && count < MAX_SWEEP_VALUES;
+         token = strtok_r(NULL, ",", &state)) {
+        values[count++] = (size_t) strtoull(token, NULL, 10);
+    }
+    return count;
+}
+
+/***
+ * Main function
+ * @param argc number of arguments
+ * @param argv the arguments
+ * @return error code
+ */
+int main(int argc, char *argv[]) {
+    int option, mode_index, mode_count = 0, capacity_count = 3, thread_count = 2, payload_count = 3;
+    int strategy_count = 2, capacity_index, thread_index, payload_index, strategy_index, first = 1;
+    int kernel_count = 0, kernel_index;
+    bench_mode_t *selected_modes[MAX_SWEEP_VALUES];
+    produce_kernel_t *selected_kernels[MAX_SWEEP_VALUES];
+    size_t capacities[MAX_SWEEP_VALUES] = {16, 128, 1024};
+    int producers[MAX_SWEEP_VALUES] = {1, 2}, consumers[MAX_SWEEP_VALUES] = {1, 2};
+    size_t payloads[MAX_SWEEP_VALUES] = {0, 64, 1024};
+    unsigned int spin_limits[MAX_SWEEP_VALUES] = {DEFAULT_SPIN_LIMIT, 0};
+    unsigned int yield_limits[MAX_SWEEP_VALUES] = {DEFAULT_YIELD_LIMIT, 0};
+    buffer_memory_policy_t memory_policy;
+    char *token, *state;
+
+    item_count = DEFAULT_ITEM_COUNT;
+
+    while ((option = getopt(argc, argv, "m:s:t:P:w:f:M:n:h")) != -1) {
+        switch (option) {
+            case 'm':
+                for (token = strtok_r(optarg, ",", &state); token != NULL; token = strtok_r(NULL, ",", &state)) {
+                    for (mode_index = 0; mode_index < (int) (sizeof(modes) / sizeof(modes[0])); mode_index++) {
+                        if (strcmp(token, modes[mode_index].name) == 0 && mode_count < MAX_SWEEP_VALUES) {
+                            selected_modes[mode_count++] = &modes[mode_index];
+                            break;
+                        }
+                    }
+                    if (mode_index == (int) (sizeof(modes) / sizeof(modes[0]))) {
+                        fprintf(stderr, "Unknown mode %s\n", token);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                break;
+            case 's':
+                capacity_count = parse_sizes(optarg, capacities);
+                break;
+            case 't':
+                thread_count = 0;
+                for (token = strtok_r(optarg, ",", &state); token != NULL && thread_count < MAX_SWEEP_VALUES;
+                     token = strtok_r(NULL, ",", &state)) {
+                    if (sscanf(token, "%dx%d", &producers[thread_count], &consumers[thread_count]) != 2 ||
+                        producers[thread_count] < 1 || consumers[thread_count] < 1) {
+                        fprintf(stderr, "Invalid thread counts %s\n", token);
+                        exit(EXIT_FAILURE);
+                    }
+                    thread_count++;
+                }
+                break;
+            case 'P':
+                payload_count = parse_sizes(optarg, payloads);
+                break;
+            case 'w':
+                strategy_count = 0;
+                for (token = strtok_r(optarg, ":", &state); token != NULL && strategy_count < MAX_SWEEP_VALUES;
+                     token = strtok_r(NULL, ":", &state)) {
+                    if (sscanf(token, "%u,%u", &spin_limits[strategy_count], &yield_limits[strategy_count]) != 2) {
+                        fprintf(stderr, "Invalid wait strategy %s\n", token);
+                        exit(EXIT_FAILURE);
+                    }
+                    strategy_count++;
+                }
+                break;
+            case 'f':
+                for (token = strtok_r(optarg, ",", &state); token != NULL; token = strtok_r(NULL, ",", &state)) {
+                    for (kernel_index = 0; kernel_index < KERNEL_COUNT; kernel_index++) {
+                        if (strcmp(token, kernels[kernel_index].name) == 0 && kernel_count < MAX_SWEEP_VALUES) {
+                            selected_kernels[kernel_count++] = &kernels[kernel_index];
+                            break;
+                        }
+                    }
+                    if (kernel_index == KERNEL_COUNT) {
+                        fprintf(stderr, "Unknown produce kernel %s\n", token);
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                break;
+            case 'M':
+                if (buffer_memory_parse(optarg, &memory_policy) != 0) {
+                    fprintf(stderr, "Invalid buffer memory options %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                buffer_memory_configure(&memory_policy);
+                break;
+            case 'n':
+                item_count = strtoull(optarg, NULL, 10);
+                break;
+            default:
+                print_usage(argv[0]);
+                exit(option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+
+    if (item_count < 1) {
+        fprintf(stderr, "The number of items must be at least 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (capacity_index = 0; capacity_index < capacity_count; capacity_index++) {
+        if (capacities[capacity_index] < 1) {
+            fprintf(stderr, "The buffer capacity must be at least 1\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (mode_count == 0) {
+        for (mode_index = 0; mode_index < (int) (sizeof(modes) / sizeof(modes[0])); mode_index++) {
+            selected_modes[mode_count++] = &modes[mode_index];
+        }
+    }
+
+    if (kernel_count == 0) {
+        selected_kernels[kernel_count++] = &kernels[0];
+    }
+
+    printf("[\n");
+    for (mode_index = 0; mode_index < mode_count; mode_index++) {
+        mode = selected_modes[mode_index];
+        for (thread_index = 0; thread_index < thread_count; thread_index++) {
+            producer_count = producers[thread_index];
+            consumer_count = consumers[thread_index];
+            if (mode->single_producer_consumer && (producer_count != 1 || consumer_count != 1)) {
+                continue;
+            }
+            for (capacity_index = 0; capacity_index < capacity_count; capacity_index++) {
+                for (payload_index = 0; payload_index < payload_count; payload_index++) {
+                    payload_size = payloads[payload_index];
+                    // the wait strategy only matters to the modes that use it
+                    for (strategy_index = 0; strategy_index < (mode->uses_wait_strategy ? strategy_count : 1);
+                         strategy_index++) {
+                        for (kernel_index = 0; kernel_index < kernel_count; kernel_index++) {
+                            kernel = selected_kernels[kernel_index];
+                            run(capacities[capacity_index], spin_limits[strategy_index],
+                                yield_limits[strategy_index], first);
+                            first = 0;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    printf("\n]\n");
+
+    return 0;
+}
@@ -0,0 +1,225 @@
+/***
+ * Benchmark of the header-only BoundedBuffer template
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Moves the same number of items from one producer to one consumer through BoundedBuffer instantiations that
+ * differ in synchronization policy, element type and batching, and reports the throughput of each. The
+ * std::unique_ptr run checks that move-only elements arrive intact and in order. The record runs move 4 KiB
+ * records once by value with push and pop and once in place with the claim and peek guards, commit and release.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "bounded_buffer.hpp"
+
+#define DEFAULT_ITEM_COUNT 10000000ULL
+#define BUFFER_CAPACITY 1000
+#define BATCH_SIZE 64
+#define RECORD_SIZE 4096
+#define RECORD_CAPACITY 64
+
+/***
+ * A large payload, the first word carries the index of the item
+ */
+struct Record {
+    unsigned long long index;
+    unsigned char bytes[RECORD_SIZE - sizeof(unsigned long long)];
+};
+
+using bounded_buffer::BoundedBuffer;
+using bounded_buffer::MutexPolicy;
+using bounded_buffer::SpscPolicy;
+
+/***
+ * The buffers under test, static since their storage is part of the object
+ */
+static BoundedBuffer<long double, BUFFER_CAPACITY, SpscPolicy> spsc_buffer;
+static BoundedBuffer<long double, BUFFER_CAPACITY, MutexPolicy> mutex_buffer;
+static BoundedBuffer<std::unique_ptr<unsigned long long>, BUFFER_CAPACITY, SpscPolicy> pointer_buffer;
+static BoundedBuffer<Record, RECORD_CAPACITY, SpscPolicy> record_buffer;
+
+/***
+ * Run a producer and a consumer to completion
+ * @param producer the producer function
+ * @param consumer the consumer function
+ * @return the elapsed time in seconds
+ */
+template<typename Producer, typename Consumer>
+static double run(Producer producer, Consumer consumer) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread consumer_thread(consumer);
+    std::thread producer_thread(producer);
+
+    producer_thread.join();
+    consumer_thread.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/***
+ * Move items one by one through a buffer of long doubles
+ * @param buffer the buffer
+ * @param item_count the number of items
+ * @return the elapsed time in seconds
+ */
+template<typename Buffer>
+static double run_single(Buffer &buffer, unsigned long long item_count) {
+    return run([&] {
+        for (unsigned long long item_index = 0; item_index < item_count; item_index++) {
+            buffer.push((long double) item_index);
+        }
+    }, [&] {
+        for (unsigned long long item_index = 0; item_index < item_count; item_index++) {
+            buffer.pop();
+        }
+    });
+}
+
+/***
+ * Move items in batches through a buffer of long doubles
+ * @param buffer the buffer
+ * @param item_count the number of items
+ * @return the elapsed time in seconds
+ */
+template<typename Buffer>
+static double run_batch(Buffer &buffer, unsigned long long item_count) {
+    return run([&] {
+        long double items[BATCH_SIZE];
+        for (unsigned long long item_index = 0; item_index < item_count; item_index += BATCH_SIZE) {
+            std::size_t count = (item_count - item_index < BATCH_SIZE) ? item_count - item_index : BATCH_SIZE;
+            for (std::size_t batch_index = 0; batch_index < count; batch_index++) {
+                items[batch_index] = (long double) (item_index + batch_index);
+            }
+            buffer.push_batch(items, count);
+        }
+    }, [&] {
+        long double items[BATCH_SIZE];
+        for (unsigned long long item_index = 0; item_index < item_count;) {
+            item_index += buffer.pop_batch(items, BATCH_SIZE);
+        }
+    });
+}
+
+/***
+ * Fill every byte of a record
+ * @param record the record
+ * @param item_index the index of the item the record carries
+ */
+static void fill_record(Record &record, unsigned long long item_index) {
+    record.index = item_index;
+    std::memset(record.bytes, (int) item_index, sizeof(record.bytes));
+}
+
+/***
+ * Read a byte of every cache line of a record and check that it carries the expected item
+ * @param record the record
+ * @param item_index the index of the item the record should carry
+ * @param intact set to false if the record carries another item
+ * @return the sum of the bytes read
+ */
+static unsigned long long read_record(const Record &record, unsigned long long item_index, bool &intact) {
+    unsigned long long sum = 0;
+
+    intact = intact && record.index == item_index;
+    for (std::size_t byte = 0; byte < sizeof(record.bytes); byte += 64) {
+        sum += record.bytes[byte];
+    }
+    return sum;
+}
+
+/***
+ * Move records through the record buffer, filling and reading each one completely
+ * @param item_count the number of records
+ * @param in_place set to write and read the records in their slots instead of copying them
+ * @param intact set to false if a record arrives out of order
+ * @return the elapsed time in seconds
+ */
+static double run_records(unsigned long long item_count, bool in_place, bool &intact) {
+    return run([&] {
+        Record local;
+        for (unsigned long long item_index = 0; item_index < item_count; item_index++) {
+            if (in_place) {
+                // the claim hands the slot back if anything throws before the commit
+                auto slot = record_buffer.claim();
+                fill_record(*slot.get(), item_index);
+                slot.commit();
+            } else {
+                fill_record(local, item_index);
+                record_buffer.push(local);
+            }
+        }
+    }, [&] {
+        Record local;
+        unsigned long long sum = 0;
+        for (unsigned long long item_index = 0; item_index < item_count; item_index++) {
+            if (in_place) {
+                // the peek leaves the record in the buffer if anything throws before the release
+                auto oldest = record_buffer.peek();
+                sum += read_record(*oldest, item_index, intact);
+                oldest.release();
+            } else {
+                local = record_buffer.pop();
+                sum += read_record(local, item_index, intact);
+            }
+        }
+        volatile unsigned long long sink = sum;
+        (void) sink;
+    });
+}
+
+/***
+ * Main function
+ * @param argc number of arguments
+ * @param argv the arguments, optionally the number of items to move
+ * @return error code
+ */
+int main(int argc, char *argv[]) {
+    unsigned long long item_count = DEFAULT_ITEM_COUNT;
+    double seconds;
+    bool intact = true;
+
+    if (argc > 1) {
+        item_count = std::strtoull(argv[1], NULL, 10);
+    }
+
+    seconds = run_single(spsc_buffer, item_count);
+    std::printf("spsc policy:             %.0f items/s\n", item_count / seconds);
+
+    seconds = run_batch(spsc_buffer, item_count);
+    std::printf("spsc policy, batched:    %.0f items/s\n", item_count / seconds);
+
+    seconds = run_single(mutex_buffer, item_count);
+    std::printf("mutex policy:            %.0f items/s\n", item_count / seconds);
+
+    seconds = run_batch(mutex_buffer, item_count);
+    std::printf("mutex policy, batched:   %.0f items/s\n", item_count / seconds);
+
+    seconds = run([&] {
+        for (unsigned long long item_index = 0; item_index < item_count; item_index++) {
+            pointer_buffer.push(std::unique_ptr<unsigned long long>(new unsigned long long(item_index)));
+        }
+    }, [&] {
+        for (unsigned long long item_index = 0; item_index < item_count; item_index++) {
+            std::unique_ptr<unsigned long long> item = pointer_buffer.pop();
+            intact = intact && item && *item == item_index;
+        }
+    });
+    std::printf("spsc policy, unique_ptr: %.0f items/s\n", item_count / seconds);
+
+    seconds = run_records(item_count / 16, false, intact);
+    std::printf("4 KiB records, copied:   %.0f items/s\n", item_count / 16 / seconds);
+
+    seconds = run_records(item_count / 16, true, intact);
+    std::printf("4 KiB records, in place: %.0f items/s\n", item_count / 16 / seconds);
+
+    if (!intact) {
+        std::printf("The move-only items or the records did not arrive intact\n");
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+/***
+ * Core-to-core latency report of a machine
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Measures the one way cache line handoff latency between every pair of CPUs the process may run on and prints it
+ * as one JSON object together with the placement the autotuner chooses for one producer and one consumer and the
+ * fastest, median and slowest pair, so that the output of different machines can be compared directly.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "core_latency.h"
+
+/***
+ * Compare two latencies for sorting
+ * @param first the first latency
+ * @param second the second latency
+ * @return negative, zero or positive like strcmp
+ */
+static int compare_latencies(const void *first, const void *second) {
+    double a = *(const double *) first, b = *(const double *) second;
+    return (a > b) - (a < b);
+}
+
+/***
+ * Main function
+ * @param argc number of arguments
+ * @param argv the arguments, optionally the number of round trips of every sample
+ * @return error code
+ */
+int main(int argc, char *argv[]) {
+    core_latency_matrix_t matrix;
+    unsigned int round_trips = DEFAULT_PROBE_ROUND_TRIPS;
+    int error_code, first, second, pair_count = 0, cpus[2];
+    double *pairs;
+
+    if (argc > 1) {
+        round_trips = (unsigned int) strtoul(argv[1], NULL, 10);
+    }
+
+    error_code = core_latency_measure(&matrix, round_trips);
+    if (error_code != 0) {
+        printf("Could not measure core-to-core latency, error code = %d\n", error_code);
+        return EXIT_FAILURE;
+    }
+
+    pairs = (double *) malloc(sizeof(double) * matrix.count * matrix.count);
+    error_code = (pairs == NULL) ? ENOMEM : core_latency_place(&matrix, cpus, 1, 1);
+    if (error_code != 0) {
+        printf("Could not place threads, error code = %d\n", error_code);
+        return EXIT_FAILURE;
+    }
+    for (first = 0; first < matrix.count; first++) {
+        for (second = first + 1; second < matrix.count; second++) {
+            pairs[pair_count++] = matrix.nanoseconds[first * matrix.count + second];
+        }
+    }
+    qsort(pairs, pair_count, sizeof(double), compare_latencies);
+
+    printf("{\"cpus\": [");
+    for (first = 0; first < matrix.count; first++) {
+        printf("%s%d", (first == 0) ? "" : ", ", matrix.cpus[first]);
+    }
+    printf("],\n \"latency_ns\": [");
+    for (first = 0; first < matrix.count; first++) {
+        printf("%s[", (first == 0) ? "" : ",\n                ");
+        for (second = 0; second < matrix.count; second++) {
+            printf("%s%.1f", (second == 0) ? "" : ", ", matrix.nanoseconds[first * matrix.count + second]);
+        }
+        printf("]");
+    }
+    printf("],\n \"placement\": {\"producer\": %d, \"consumer\": %d}", cpus[0], cpus[1]);
+    if (pair_count > 0) {
+        printf(",\n \"pair_latency_ns\": {\"min\": %.1f, \"median\": %.1f, \"max\": %.1f}", pairs[0],
+               pairs[pair_count / 2], pairs[pair_count - 1]);
+    }
+    printf("}\n");
+
+    free(pairs);
+    core_latency_destroy(&matrix);
+    return 0;
+}
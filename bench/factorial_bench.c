@@ -0,0 +1,90 @@
+/***
+ * Benchmark of the exact factorial engine against the naive loop
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Computes the factorial of every given argument once by multiplying 2..n one by one into the result and once
+ * with the product tree and Karatsuba multiplication of bignum_factorial, checks that both agree and prints one
+ * JSON object per argument with the size of the result and the time each method took.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bignum.h"
+
+#define MAX_ARGUMENTS 16
+
+/***
+ * Read the monotonic clock
+ * @return the current time in seconds
+ */
+static double now_seconds(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
+
+/***
+ * Time one way of computing a factorial
+ * @param method the method
+ * @param result the number the factorial is stored in
+ * @param number the argument
+ * @return the elapsed seconds
+ */
+static double measure(int (*method)(bignum_t *, unsigned int), bignum_t *result, unsigned int number) {
+    double start = now_seconds();
+    int error_code = method(result, number);
+
+    if (error_code != 0) {
+        printf("Could not compute factorial, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+    return now_seconds() - start;
+}
+
+/***
+ * Main function
+ * @param argc number of arguments
+ * @param argv the arguments, optionally a comma separated list of factorial arguments
+ * @return error code
+ */
+int main(int argc, char *argv[]) {
+    unsigned int arguments[MAX_ARGUMENTS] = {100, 1000, 10000, 50000};
+    int argument_count = 4, argument_index;
+    char *token, *state;
+    bignum_t naive, tree;
+    double naive_seconds, tree_seconds;
+
+    if (argc > 1) {
+        argument_count = 0;
+        for (token = strtok_r(argv[1], ",", &state); token != NULL && argument_count < MAX_ARGUMENTS;
+             token = strtok_r(NULL, ",", &state)) {
+            arguments[argument_count++] = (unsigned int) strtoul(token, NULL, 10);
+        }
+    }
+
+    bignum_init(&naive);
+    bignum_init(&tree);
+
+    printf("[\n");
+    for (argument_index = 0; argument_index < argument_count; argument_index++) {
+        naive_seconds = measure(bignum_factorial_naive, &naive, arguments[argument_index]);
+        tree_seconds = measure(bignum_factorial, &tree, arguments[argument_index]);
+        if (bignum_compare(&naive, &tree) != 0) {
+            printf("The factorials of %u do not agree\n", arguments[argument_index]);
+            exit(EXIT_FAILURE);
+        }
+
+        printf("  {\"number\": %u, \"bits\": %zu, \"naive_seconds\": %.6f, \"binary_splitting_seconds\": %.6f, "
+               "\"speedup\": %.2f}%s\n", arguments[argument_index], bignum_bits(&tree), naive_seconds, tree_seconds,
+               naive_seconds / tree_seconds, (argument_index + 1 < argument_count) ? "," : "");
+    }
+    printf("]\n");
+
+    bignum_destroy(&naive);
+    bignum_destroy(&tree);
+    return 0;
+}
@@ -0,0 +1,239 @@
+/***
+ * Benchmark of the false sharing between the producer and consumer control state of the SPSC ring
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Moves the same number of items through two rings that run the same algorithm: a packed ring whose indices and
+ * parkers share one cache line and which reads the remote index on every operation, and the cache line isolated
+ * spsc_ring_t with cached remote indices. The difference in throughput is the cost of the producer and consumer
+ * invalidating each other's cache lines.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "spsc_ring.h"
+
+#define DEFAULT_ITEM_COUNT 20000000ULL
+#define RING_CAPACITY 1024
+#define SPINS_BEFORE_YIELD 64
+
+/***
+ * The ring with all control state packed together, the layout spsc_ring_t had before it was split by owner
+ */
+typedef struct packed_ring {
+    long double *slots;
+    size_t capacity;
+    size_t mask;
+    atomic_size_t head;
+    atomic_size_t tail;
+    wait_parker_t not_full;
+    wait_parker_t not_empty;
+} packed_ring_t;
+
+/***
+ * The rings under test and the number of items to move through them
+ */
+packed_ring_t packed;
+spsc_ring_t padded;
+unsigned long long item_count = DEFAULT_ITEM_COUNT;
+
+/***
+ * Append an item to the packed ring without waiting
+ * @param ring the ring to append to
+ * @param item the item to append
+ * @return 1 if the item was appended, 0 if the ring was full
+ */
+static int packed_try_push(packed_ring_t *ring, long double item) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail - head == ring->capacity) {
+        return 0;
+    }
+
+    ring->slots[tail & ring->mask] = item;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    wait_parker_notify(&ring->not_empty, 1);
+    return 1;
+}
+
+/***
+ * Remove the oldest item from the packed ring without waiting
+ * @param ring the ring to remove from
+ * @param item location where the removed item is stored
+ * @return 1 if an item was removed, 0 if the ring was empty
+ */
+static int packed_try_pop(packed_ring_t *ring, long double *item) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head == tail) {
+        return 0;
+    }
+
+    *item = ring->slots[head & ring->mask];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    wait_parker_notify(&ring->not_full, 1);
+    return 1;
+}
+
+/***
+ * Back off after a failed attempt, spinning first and yielding the processor every few attempts
+ * @param attempts the number of consecutive failed attempts
+ */
+static void back_off(unsigned int *attempts) {
+    if (++*attempts % SPINS_BEFORE_YIELD == 0) {
+        sched_yield();
+    } else {
+        cpu_relax();
+    }
+}
+
+/***
+ * The producer for the packed ring
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *packed_producer(void *dummy) {
+    unsigned long long item_index;
+    unsigned int attempts = 0;
+
+    for (item_index = 0; item_index < item_count; item_index++) {
+        while (!packed_try_push(&packed, (long double) item_index)) {
+            back_off(&attempts);
+        }
+    }
+    return NULL;
+}
+
+/***
+ * The consumer for the packed ring
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *packed_consumer(void *dummy) {
+    unsigned long long item_index;
+    unsigned int attempts = 0;
+    long double item;
+
+    for (item_index = 0; item_index < item_count; item_index++) {
+        while (!packed_try_pop(&packed, &item)) {
+            back_off(&attempts);
+        }
+    }
+    return NULL;
+}
+
+/***
+ * The producer for the cache line isolated ring
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *padded_producer(void *dummy) {
+    unsigned long long item_index;
+    unsigned int attempts = 0;
+
+    for (item_index = 0; item_index < item_count; item_index++) {
+        while (!spsc_ring_try_push(&padded, (long double) item_index)) {
+            back_off(&attempts);
+        }
+    }
+    return NULL;
+}
+
+/***
+ * The consumer for the cache line isolated ring
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *padded_consumer(void *dummy) {
+    unsigned long long item_index;
+    unsigned int attempts = 0;
+    long double item;
+
+    for (item_index = 0; item_index < item_count; item_index++) {
+        while (!spsc_ring_try_pop(&padded, &item)) {
+            back_off(&attempts);
+        }
+    }
+    return NULL;
+}
+
+/***
+ * Run a producer and a consumer to completion
+ * @param producer the producer function
+ * @param consumer the consumer function
+ * @return the elapsed time in seconds
+ */
+double run(void *(*producer)(void *), void *(*consumer)(void *)) {
+    int error_code;
+    pthread_t producer_thread, consumer_thread;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    error_code = pthread_create(&consumer_thread, NULL, consumer, NULL);
+    if (error_code != 0) {
+        printf("Could not create consumer thread, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+
+    error_code = pthread_create(&producer_thread, NULL, producer, NULL);
+    if (error_code != 0) {
+        printf("Could not create producer thread, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_join(producer_thread, NULL);
+    pthread_join(consumer_thread, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/***
+ * Main function
+ * @param argc number of arguments
+ * @param argv the arguments, optionally the number of items to move
+ * @return error code
+ */
+int main(int argc, char *argv[]) {
+    int error_code;
+    double packed_seconds, padded_seconds;
+
+    if (argc > 1) {
+        item_count = strtoull(argv[1], NULL, 10);
+    }
+
+    // set up the packed ring by hand, it has no init function of its own
+    packed.slots = (long double *) malloc(sizeof(long double) * RING_CAPACITY);
+    if (packed.slots == NULL) {
+        printf("Could not allocate memory for packed ring\n");
+        exit(EXIT_FAILURE);
+    }
+    packed.capacity = RING_CAPACITY;
+    packed.mask = RING_CAPACITY - 1;
+    atomic_init(&packed.head, 0);
+    atomic_init(&packed.tail, 0);
+    wait_parker_init(&packed.not_full);
+    wait_parker_init(&packed.not_empty);
+
+    error_code = spsc_ring_init(&padded, RING_CAPACITY);
+    if (error_code != 0) {
+        printf("Could not initialize ring buffer, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+
+    packed_seconds = run(packed_producer, packed_consumer);
+    padded_seconds = run(padded_producer, padded_consumer);
+
+    printf("packed control block:   %.0f items/s\n", item_count / packed_seconds);
+    printf("isolated control block: %.0f items/s\n", item_count / padded_seconds);
+    printf("speedup: %.2fx\n", packed_seconds / padded_seconds);
+
+    free(packed.slots);
+    spsc_ring_destroy(&padded);
+    return 0;
+}
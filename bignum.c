@@ -0,0 +1,466 @@
+/***
+ * Arbitrary-precision unsigned integers and exact factorials
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bignum.h"
+
+#define KARATSUBA_THRESHOLD 32
+#define LEAF_FACTORS 64
+
+void bignum_init(bignum_t *number) {
+    number->limbs = NULL;
+    number->length = 0;
+    number->capacity = 0;
+}
+
+void bignum_destroy(bignum_t *number) {
+    free(number->limbs);
+    bignum_init(number);
+}
+
+/***
+ * Make sure a number has room for a number of limbs, keeping its value
+ * @param number the number
+ * @param capacity the number of limbs
+ * @return 0 on success, an error number otherwise
+ */
+static int reserve(bignum_t *number, size_t capacity) {
+    uint32_t *limbs;
+
+    if (capacity <= number->capacity) {
+        return 0;
+    }
+
+    // grow geometrically so that a number built up by repeated small multiplications reallocates rarely
+    if (capacity < 2 * number->capacity) {
+        capacity = 2 * number->capacity;
+    }
+    limbs = (uint32_t *) realloc(number->limbs, sizeof(uint32_t) * capacity);
+    if (limbs == NULL) {
+        return ENOMEM;
+    }
+    number->limbs = limbs;
+    number->capacity = capacity;
+    return 0;
+}
+
+/***
+ * Drop the leading zero limbs of a number
+ * @param number the number
+ */
+static void trim(bignum_t *number) {
+    while (number->length > 0 && number->limbs[number->length - 1] == 0) {
+        number->length--;
+    }
+}
+
+int bignum_set(bignum_t *number, uint64_t value) {
+    int error_code = reserve(number, 2);
+    if (error_code != 0) {
+        return error_code;
+    }
+    number->limbs[0] = (uint32_t) value;
+    number->limbs[1] = (uint32_t) (value >> 32);
+    number->length = 2;
+    trim(number);
+    return 0;
+}
+
+int bignum_multiply_small(bignum_t *number, uint32_t factor) {
+    uint64_t carry = 0;
+    size_t index;
+    int error_code = reserve(number, number->length + 1);
+
+    if (error_code != 0) {
+        return error_code;
+    }
+    for (index = 0; index < number->length; index++) {
+        carry += (uint64_t) number->limbs[index] * factor;
+        number->limbs[index] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    number->limbs[number->length++] = (uint32_t) carry;
+    trim(number);
+    return 0;
+}
+
+/***
+ * Add two limb arrays
+ * @param sum the array the sum is stored in, as long as the longer operand
+ * @param left the first operand
+ * @param left_length the number of limbs of the first operand
+ * @param right the second operand
+ * @param right_length the number of limbs of the second operand
+ * @return the carry out of the most significant limb
+ */
+static uint32_t add_limbs(uint32_t *sum, const uint32_t *left, size_t left_length, const uint32_t *right,
+                          size_t right_length) {
+    uint64_t carry = 0;
+    size_t index;
+
+    if (left_length < right_length) {
+        const uint32_t *swap = left;
+        size_t swap_length = left_length;
+        left = right;
+        left_length = right_length;
+        right = swap;
+        right_length = swap_length;
+    }
+    for (index = 0; index < right_length; index++) {
+        carry += (uint64_t) left[index] + right[index];
+        sum[index] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    for (; index < left_length; index++) {
+        carry += left[index];
+        sum[index] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    return (uint32_t) carry;
+}
+
+/***
+ * Add a limb array into another one, the sum must fit into the target
+ * @param target the array that is added to
+ * @param target_length the number of limbs of the target
+ * @param addend the array that is added
+ * @param addend_length the number of limbs of the addend, at most target_length
+ */
+static void add_into(uint32_t *target, size_t target_length, const uint32_t *addend, size_t addend_length) {
+    uint64_t carry = 0;
+    size_t index;
+
+    for (index = 0; index < addend_length; index++) {
+        carry += (uint64_t) target[index] + addend[index];
+        target[index] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    for (; carry != 0 && index < target_length; index++) {
+        carry += target[index];
+        target[index] = (uint32_t) carry;
+        carry >>= 32;
+    }
+}
+
+/***
+ * Subtract a limb array from another one, the difference must not be negative
+ * @param target the array that is subtracted from
+ * @param target_length the number of limbs of the target
+ * @param subtrahend the array that is subtracted
+ * @param subtrahend_length the number of limbs of the subtrahend, at most target_length
+ */
+static void subtract_from(uint32_t *target, size_t target_length, const uint32_t *subtrahend,
+                          size_t subtrahend_length) {
+    uint64_t borrow = 0, difference;
+    size_t index;
+
+    for (index = 0; index < subtrahend_length; index++) {
+        difference = (uint64_t) target[index] - subtrahend[index] - borrow;
+        target[index] = (uint32_t) difference;
+        borrow = (difference >> 32) & 1;
+    }
+    for (; borrow != 0 && index < target_length; index++) {
+        difference = (uint64_t) target[index] - borrow;
+        target[index] = (uint32_t) difference;
+        borrow = (difference >> 32) & 1;
+    }
+}
+
+/***
+ * Multiply two limb arrays with the schoolbook method
+ * @param product the array the product is stored in, left_length + right_length limbs
+ * @param left the first factor
+ * @param left_length the number of limbs of the first factor
+ * @param right the second factor
+ * @param right_length the number of limbs of the second factor
+ */
+static void multiply_schoolbook(uint32_t *product, const uint32_t *left, size_t left_length, const uint32_t *right,
+                                size_t right_length) {
+    size_t left_index, right_index;
+    uint64_t carry;
+
+    memset(product, 0, sizeof(uint32_t) * (left_length + right_length));
+    for (left_index = 0; left_index < left_length; left_index++) {
+        carry = 0;
+        for (right_index = 0; right_index < right_length; right_index++) {
+            carry += (uint64_t) left[left_index] * right[right_index] + product[left_index + right_index];
+            product[left_index + right_index] = (uint32_t) carry;
+            carry >>= 32;
+        }
+        product[left_index + right_length] = (uint32_t) carry;
+    }
+}
+
+/***
+ * Get the number of scratch limbs a balanced Karatsuba multiplication needs
+ * @param length the number of limbs of the longer factor
+ * @return the number of limbs
+ */
+static size_t karatsuba_scratch(size_t length) {
+    size_t size = 0;
+
+    // every level keeps two half-size sums and their product while it recurses on the next one
+    while (length >= KARATSUBA_THRESHOLD) {
+        length = length - length / 2 + 1;
+        size += 4 * length;
+    }
+    return size;
+}
+
+/***
+ * Multiply two limb arrays with Karatsuba's method
+ * @param product the array the product is stored in, left_length + right_length limbs
+ * @param left the first factor
+ * @param left_length the number of limbs of the first factor, at least right_length
+ * @param right the second factor
+ * @param right_length the number of limbs of the second factor
+ * @param scratch room for the intermediate results
+ */
+static void multiply_karatsuba(uint32_t *product, const uint32_t *left, size_t left_length, const uint32_t *right,
+                               size_t right_length, uint32_t *scratch) {
+    size_t low, high, offset, chunk, sum_length, middle_length;
+    uint32_t *left_sum, *right_sum, *middle;
+
+    if (right_length < KARATSUBA_THRESHOLD) {
+        multiply_schoolbook(product, left, left_length, right, right_length);
+        return;
+    }
+
+    // a much longer left factor is cut into pieces as long as the right one, which are multiplied separately
+    if (left_length >= 2 * right_length) {
+        memset(product, 0, sizeof(uint32_t) * (left_length + right_length));
+        for (offset = 0; offset < left_length; offset += right_length) {
+            chunk = (left_length - offset < right_length) ? left_length - offset : right_length;
+            if (chunk == right_length) {
+                multiply_karatsuba(scratch, left + offset, chunk, right, right_length, scratch + chunk + right_length);
+            } else {
+                multiply_karatsuba(scratch, right, right_length, left + offset, chunk, scratch + chunk + right_length);
+            }
+            add_into(product + offset, left_length + right_length - offset, scratch, chunk + right_length);
+        }
+        return;
+    }
+
+    // with B = 2^(32 * low), left = a1 * B + a0 and right = b1 * B + b0, the product is
+    // a1 * b1 * B^2 + ((a0 + a1) * (b0 + b1) - a0 * b0 - a1 * b1) * B + a0 * b0
+    low = left_length / 2;
+    high = left_length - low;
+    multiply_karatsuba(product, left, low, right, low, scratch);
+    multiply_karatsuba(product + 2 * low, left + low, high, right + low, right_length - low, scratch);
+
+    sum_length = high + 1;
+    left_sum = scratch;
+    right_sum = scratch + sum_length;
+    middle = scratch + 2 * sum_length;
+    left_sum[high] = add_limbs(left_sum, left + low, high, left, low);
+    memset(right_sum, 0, sizeof(uint32_t) * sum_length);
+    right_sum[(right_length - low > low) ? right_length - low : low] = add_limbs(right_sum, right + low,
+                                                                             right_length - low, right, low);
+    multiply_karatsuba(middle, left_sum, sum_length, right_sum, sum_length, middle + 2 * sum_length);
+
+    middle_length = 2 * sum_length;
+    subtract_from(middle, middle_length, product, 2 * low);
+    subtract_from(middle, middle_length, product + 2 * low, high + right_length - low);
+    while (middle_length > 0 && middle[middle_length - 1] == 0) {
+        middle_length--;
+    }
+    add_into(product + low, left_length + right_length - low, middle, middle_length);
+}
+
+int bignum_multiply(bignum_t *product, const bignum_t *left, const bignum_t *right) {
+    uint32_t *scratch;
+    int error_code;
+
+    if (left->length < right->length) {
+        const bignum_t *swap = left;
+        left = right;
+        right = swap;
+    }
+    if (right->length == 0) {
+        product->length = 0;
+        return 0;
+    }
+
+    error_code = reserve(product, left->length + right->length);
+    if (error_code != 0) {
+        return error_code;
+    }
+
+    if (right->length < KARATSUBA_THRESHOLD) {
+        multiply_schoolbook(product->limbs, left->limbs, left->length, right->limbs, right->length);
+    } else {
+        scratch = (uint32_t *) malloc(sizeof(uint32_t) * (4 * (left->length + right->length) +
+                                                          karatsuba_scratch(left->length)));
+        if (scratch == NULL) {
+            return ENOMEM;
+        }
+        multiply_karatsuba(product->limbs, left->limbs, left->length, right->limbs, right->length, scratch);
+        free(scratch);
+    }
+
+    product->length = left->length + right->length;
+    trim(product);
+    return 0;
+}
+
+int bignum_shift_left(bignum_t *number, size_t bits) {
+    size_t limbs = bits / 32, index;
+    unsigned int shift = (unsigned int) (bits % 32);
+    int error_code;
+
+    if (number->length == 0) {
+        return 0;
+    }
+    error_code = reserve(number, number->length + limbs + 1);
+    if (error_code != 0) {
+        return error_code;
+    }
+
+    number->limbs[number->length + limbs] = 0;
+    for (index = number->length; index-- > 0;) {
+        if (shift != 0) {
+            number->limbs[index + limbs + 1] |= number->limbs[index] >> (32 - shift);
+        }
+        number->limbs[index + limbs] = number->limbs[index] << shift;
+    }
+    memset(number->limbs, 0, sizeof(uint32_t) * limbs);
+    number->length += limbs + 1;
+    trim(number);
+    return 0;
+}
+
+int bignum_compare(const bignum_t *left, const bignum_t *right) {
+    size_t index;
+
+    if (left->length != right->length) {
+        return (left->length < right->length) ? -1 : 1;
+    }
+    for (index = left->length; index-- > 0;) {
+        if (left->limbs[index] != right->limbs[index]) {
+            return (left->limbs[index] < right->limbs[index]) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+size_t bignum_bits(const bignum_t *number) {
+    if (number->length == 0) {
+        return 0;
+    }
+    return 32 * number->length - (size_t) __builtin_clz(number->limbs[number->length - 1]);
+}
+
+/***
+ * Multiply the odd parts of the integers in (low, high] with a product tree
+ * @param result the number the product is stored in
+ * @param low the exclusive lower bound
+ * @param high the inclusive upper bound
+ * @return 0 on success, an error number otherwise
+ */
+static int multiply_odd_parts(bignum_t *result, unsigned int low, unsigned int high) {
+    bignum_t left, right;
+    uint64_t factor = 1, odd;
+    unsigned int middle, number;
+    int error_code;
+
+    if (high - low <= LEAF_FACTORS) {
+        error_code = bignum_set(result, 1);
+
+        // pack as many factors into one limb as fit before touching the number
+        for (number = low + 1; error_code == 0 && number <= high && number != 0; number++) {
+            odd = number >> __builtin_ctz(number);
+            if (factor * odd > UINT32_MAX) {
+                error_code = bignum_multiply_small(result, (uint32_t) factor);
+                factor = odd;
+            } else {
+                factor *= odd;
+            }
+        }
+        return (error_code == 0) ? bignum_multiply_small(result, (uint32_t) factor) : error_code;
+    }
+
+    middle = low + (high - low) / 2;
+    bignum_init(&left);
+    bignum_init(&right);
+    error_code = multiply_odd_parts(&left, low, middle);
+    if (error_code == 0) {
+        error_code = multiply_odd_parts(&right, middle, high);
+    }
+    if (error_code == 0) {
+        error_code = bignum_multiply(result, &left, &right);
+    }
+    bignum_destroy(&left);
+    bignum_destroy(&right);
+    return error_code;
+}
+
+int bignum_factorial(bignum_t *result, unsigned int number) {
+    int error_code;
+
+    if (number < 2) {
+        return bignum_set(result, 1);
+    }
+
+    // n! has n - popcount(n) factors of two, which are left out of the tree and shifted in at the end
+    error_code = multiply_odd_parts(result, 1, number);
+    if (error_code != 0) {
+        return error_code;
+    }
+    return bignum_shift_left(result, number - (unsigned int) __builtin_popcount(number));
+}
+
+int bignum_factorial_naive(bignum_t *result, unsigned int number) {
+    unsigned int factor;
+    int error_code = bignum_set(result, 1);
+
+    for (factor = 2; error_code == 0 && factor <= number && factor != 0; factor++) {
+        error_code = bignum_multiply_small(result, factor);
+    }
+    return error_code;
+}
+
+int bignum_pool_init(bignum_pool_t *pool, size_t count) {
+    size_t index;
+    int error_code;
+
+    pool->numbers = (bignum_t *) malloc(sizeof(bignum_t) * count);
+    if (pool->numbers == NULL) {
+        return ENOMEM;
+    }
+    pool->count = count;
+
+    error_code = mpmc_queue_init(&pool->free_numbers, count);
+    if (error_code != 0) {
+        free(pool->numbers);
+        return error_code;
+    }
+    for (index = 0; index < count; index++) {
+        bignum_init(&pool->numbers[index]);
+        mpmc_queue_try_push(&pool->free_numbers, (long double) index);
+    }
+    return 0;
+}
+
+int bignum_pool_destroy(bignum_pool_t *pool) {
+    size_t index;
+
+    for (index = 0; index < pool->count; index++) {
+        bignum_destroy(&pool->numbers[index]);
+    }
+    free(pool->numbers);
+    return mpmc_queue_destroy(&pool->free_numbers);
+}
+
+size_t bignum_pool_acquire(bignum_pool_t *pool) {
+    return (size_t) mpmc_queue_pop(&pool->free_numbers);
+}
+
+void bignum_pool_release(bignum_pool_t *pool, size_t handle) {
+    mpmc_queue_push(&pool->free_numbers, (long double) handle);
+}
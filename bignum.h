@@ -0,0 +1,161 @@
+/***
+ * Arbitrary-precision unsigned integers and exact factorials
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * A number is an array of 32-bit limbs, least significant first, that grows on demand and keeps its storage
+ * when it is overwritten, so a number that is reused stops allocating once it has reached its working size.
+ * Products of long operands are computed with Karatsuba's method, which splits both operands in halves and
+ * needs three half-size products instead of four; short operands use the schoolbook method.
+ *
+ * bignum_factorial computes n! as a product tree (binary splitting) over the odd parts of 2..n, so the expensive
+ * multiplications are between operands of similar size where Karatsuba pays off, and applies the n - popcount(n)
+ * factors of two with a single shift at the end. bignum_factorial_naive multiplies 2..n one by one into the
+ * result and is kept as a reference for the benchmarks.
+ *
+ * A pool hands out a fixed set of numbers through a free list, so results can be passed between threads by handle
+ * while their digits stay where they were computed.
+ */
+
+#ifndef BOUNDED_BUFFER_BIGNUM_H
+#define BOUNDED_BUFFER_BIGNUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mpmc_queue.h"
+
+/***
+ * An unsigned integer, length is the number of significant limbs and 0 for zero
+ */
+typedef struct bignum {
+    uint32_t *limbs;
+    size_t length;
+    size_t capacity;
+} bignum_t;
+
+/***
+ * A fixed set of numbers, free_numbers holds the indices of the numbers not handed out
+ */
+typedef struct bignum_pool {
+    bignum_t *numbers;
+    size_t count;
+    mpmc_queue_t free_numbers;
+} bignum_pool_t;
+
+/***
+ * Initialize a number to zero without allocating
+ * @param number the number to initialize
+ */
+void bignum_init(bignum_t *number);
+
+/***
+ * Release the storage of a number
+ * @param number the number to destroy
+ */
+void bignum_destroy(bignum_t *number);
+
+/***
+ * Set a number to a machine integer
+ * @param number the number
+ * @param value the value
+ * @return 0 on success, an error number otherwise
+ */
+int bignum_set(bignum_t *number, uint64_t value);
+
+/***
+ * Multiply a number by a machine integer in place
+ * @param number the number
+ * @param factor the factor
+ * @return 0 on success, an error number otherwise
+ */
+int bignum_multiply_small(bignum_t *number, uint32_t factor);
+
+/***
+ * Multiply two numbers
+ * @param product the number the product is stored in, must not be one of the factors
+ * @param left the first factor
+ * @param right the second factor
+ * @return 0 on success, an error number otherwise
+ */
+int bignum_multiply(bignum_t *product, const bignum_t *left, const bignum_t *right);
+
+/***
+ * Multiply a number by a power of two in place
+ * @param number the number
+ * @param bits the exponent of the power of two
+ * @return 0 on success, an error number otherwise
+ */
+int bignum_shift_left(bignum_t *number, size_t bits);
+
+/***
+ * Compare two numbers
+ * @param left the first number
+ * @param right the second number
+ * @return a negative value, 0 or a positive value when left is less than, equal to or greater than right
+ */
+int bignum_compare(const bignum_t *left, const bignum_t *right);
+
+/***
+ * Get the number of bits of a number
+ * @param number the number
+ * @return the position of the highest set bit plus one, 0 for zero
+ */
+size_t bignum_bits(const bignum_t *number);
+
+/***
+ * Compute a factorial exactly with a product tree
+ * @param result the number the factorial is stored in
+ * @param number the argument
+ * @return 0 on success, an error number otherwise
+ */
+int bignum_factorial(bignum_t *result, unsigned int number);
+
+/***
+ * Compute a factorial exactly by multiplying in ascending order
+ * @param result the number the factorial is stored in
+ * @param number the argument
+ * @return 0 on success, an error number otherwise
+ */
+int bignum_factorial_naive(bignum_t *result, unsigned int number);
+
+/***
+ * Initialize a pool of numbers, all of them free
+ * @param pool the pool to initialize
+ * @param count the number of numbers in the pool
+ * @return 0 on success, an error number otherwise
+ */
+int bignum_pool_init(bignum_pool_t *pool, size_t count);
+
+/***
+ * Release a pool and the storage of all of its numbers
+ * @param pool the pool to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int bignum_pool_destroy(bignum_pool_t *pool);
+
+/***
+ * Take a free number from a pool, waiting with the wait strategy while none is free
+ * @param pool the pool
+ * @return the handle of the number
+ */
+size_t bignum_pool_acquire(bignum_pool_t *pool);
+
+/***
+ * Return a number to a pool
+ * @param pool the pool
+ * @param handle the handle of the number
+ */
+void bignum_pool_release(bignum_pool_t *pool, size_t handle);
+
+/***
+ * Get the number behind a handle
+ * @param pool the pool
+ * @param handle the handle of the number
+ * @return the number
+ */
+static inline bignum_t *bignum_pool_get(bignum_pool_t *pool, size_t handle) {
+    return &pool->numbers[handle];
+}
+
+#endif //BOUNDED_BUFFER_BIGNUM_H
@@ -0,0 +1,602 @@
+/***
+ * Generic header-only bounded buffer
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * BoundedBuffer<T, Capacity, SyncPolicy> holds up to Capacity elements of any type in storage that is part of the
+ * object. The storage is rounded up to a power of two at compile time, so the slot of a position is found by
+ * masking it with a constant. Positions never wrap back to zero.
+ *
+ * Elements are constructed in place when they are pushed and destroyed when they are popped, so move-only types
+ * such as std::unique_ptr work. Trivially copyable types skip the construction and destruction and batches of them
+ * are moved with at most two memcpy calls, one for each side of the wrap.
+ *
+ * The synchronization policy decides who may use the buffer and how threads wait:
+ *
+ * SpscPolicy allows one producer and one consumer thread. They publish positions with acquire/release atomics on
+ * separate cache lines and keep a cached copy of the other side's position, like spsc_ring_t. A waiting thread
+ * spins with a pause instruction and then yields.
+ *
+ * MutexPolicy allows any number of producers and consumers. A mutex guards both positions and threads wait on a
+ * condition variable for each side, like the semaphore and mutex pair of the demo.
+ *
+ * Producers can reserve a slot with claim, construct the element in it and publish it with commit, and consumers
+ * can use the oldest element where it is with peek and hand its slot back with release, so a large element is
+ * written once and read in place instead of being copied into and out of the buffer. claim and peek return
+ * move-only guards that hand their slot back when they go out of scope without a commit or release, so an
+ * exception between the two does not leave the mutex of MutexPolicy locked. push and pop are built on these.
+ *
+ * A policy grants runs of positions with claim and peek, which wait, or try_claim and try_peek, which grant
+ * nothing instead of waiting, and takes them back with commit and release, or with abandon when a constructor,
+ * copy or move of T throws in between. The buffer then destroys the elements of an unpublished batch and keeps an
+ * element whose move out threw, so an exception leaves the buffer usable and the mutex of MutexPolicy unlocked.
+ */
+
+#ifndef BOUNDED_BUFFER_BOUNDED_BUFFER_HPP
+#define BOUNDED_BUFFER_BOUNDED_BUFFER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace bounded_buffer {
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/***
+ * Round a capacity up to the next power of two
+ * @param value the capacity, at least 1
+ * @param power the power of two to start from
+ * @return the smallest power of two that is at least value
+ */
+constexpr std::size_t round_up_power_of_two(std::size_t value, std::size_t power = 1) {
+    return (power >= value) ? power : round_up_power_of_two(value, power * 2);
+}
+
+/***
+ * Single-producer/single-consumer synchronization with atomic positions
+ */
+class SpscPolicy {
+public:
+    static constexpr unsigned int SPIN_LIMIT = 256;
+
+    SpscPolicy() : tail_(0), cached_head_(0), head_(0), cached_tail_(0) {}
+
+    std::size_t try_claim(std::size_t capacity, std::size_t count, std::size_t &position) {
+        std::size_t granted;
+
+        position = tail_.load(std::memory_order_relaxed);
+        granted = capacity - (position - cached_head_);
+
+        // only reload the consumer's position when the cached one says there is not enough room
+        if (granted < count) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            granted = capacity - (position - cached_head_);
+        }
+        return (granted < count) ? granted : count;
+    }
+
+    std::size_t claim(std::size_t capacity, std::size_t count, std::size_t &position) {
+        std::size_t granted;
+        unsigned int spins = 0;
+
+        while ((granted = try_claim(capacity, count, position)) == 0) {
+            pause(spins);
+        }
+        return granted;
+    }
+
+    void commit(std::size_t count) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    std::size_t try_peek(std::size_t count, std::size_t &position) {
+        std::size_t granted;
+
+        position = head_.load(std::memory_order_relaxed);
+        granted = cached_tail_ - position;
+
+        // only reload the producer's position when the cached one says there are not enough elements
+        if (granted < count) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            granted = cached_tail_ - position;
+        }
+        return (granted < count) ? granted : count;
+    }
+
+    std::size_t peek(std::size_t count, std::size_t &position) {
+        std::size_t granted;
+        unsigned int spins = 0;
+
+        while ((granted = try_peek(count, position)) == 0) {
+            pause(spins);
+        }
+        return granted;
+    }
+
+    void release(std::size_t count) {
+        head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // positions are only taken by commit and release, so a granted run needs no handing back
+    void abandon() {}
+
+    /***
+     * Get the positions of the oldest element and of the next free slot, the head only from a consumer between a
+     * peek and its release and both only while no thread uses the buffer otherwise
+     */
+    std::size_t head() const { return head_.load(std::memory_order_relaxed); }
+
+    std::size_t tail() const { return tail_.load(std::memory_order_relaxed); }
+
+private:
+    /***
+     * Wait a little before the next attempt, spinning at first and yielding the processor afterwards
+     * @param spins the number of attempts so far
+     */
+    static void pause(unsigned int &spins) {
+        if (spins++ < SPIN_LIMIT) {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#endif
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail_;
+    std::size_t cached_head_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head_;
+    std::size_t cached_tail_;
+};
+
+/***
+ * Multi-producer/multi-consumer synchronization with a mutex and a condition variable per side, the mutex is held
+ * from a successful claim until the commit and from a successful peek until the release
+ */
+class MutexPolicy {
+public:
+    MutexPolicy() : tail_(0), head_(0) {}
+
+    std::size_t try_claim(std::size_t capacity, std::size_t count, std::size_t &position) {
+        mutex_.lock();
+        if (tail_ - head_ == capacity) {
+            mutex_.unlock();
+            return 0;
+        }
+        return grant(capacity - (tail_ - head_), count, position, tail_);
+    }
+
+    std::size_t claim(std::size_t capacity, std::size_t count, std::size_t &position) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&] { return tail_ - head_ < capacity; });
+        lock.release();
+        return grant(capacity - (tail_ - head_), count, position, tail_);
+    }
+
+    void commit(std::size_t count) {
+        tail_ += count;
+
+        // wake the consumers after dropping the lock so they do not block on it right away
+        mutex_.unlock();
+        notify(not_empty_, count);
+    }
+
+    std::size_t try_peek(std::size_t count, std::size_t &position) {
+        mutex_.lock();
+        if (tail_ == head_) {
+            mutex_.unlock();
+            return 0;
+        }
+        return grant(tail_ - head_, count, position, head_);
+    }
+
+    std::size_t peek(std::size_t count, std::size_t &position) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&] { return tail_ != head_; });
+        lock.release();
+        return grant(tail_ - head_, count, position, head_);
+    }
+
+    void release(std::size_t count) {
+        head_ += count;
+        mutex_.unlock();
+        notify(not_full_, count);
+    }
+
+    void abandon() {
+        mutex_.unlock();
+    }
+
+    /***
+     * Get the positions of the oldest element and of the next free slot, the head only from a consumer between a
+     * peek and its release and both only while no thread uses the buffer otherwise
+     */
+    std::size_t head() const { return head_; }
+
+    std::size_t tail() const { return tail_; }
+
+private:
+    static std::size_t grant(std::size_t available, std::size_t count, std::size_t &position, std::size_t first) {
+        position = first;
+        return (available < count) ? available : count;
+    }
+
+    static void notify(std::condition_variable &condition, std::size_t count) {
+        if (count == 1) {
+            condition.notify_one();
+        } else if (count > 1) {
+            condition.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::size_t tail_;
+    std::size_t head_;
+};
+
+/***
+ * A bounded buffer of Capacity elements of type T, synchronized by SyncPolicy
+ */
+template<typename T, std::size_t Capacity, typename SyncPolicy = MutexPolicy>
+class BoundedBuffer {
+    static_assert(Capacity > 0, "the capacity must be at least 1");
+
+    typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value> IsTrivial;
+
+public:
+    static constexpr std::size_t SLOT_COUNT = round_up_power_of_two(Capacity);
+    static constexpr std::size_t MASK = SLOT_COUNT - 1;
+
+    /***
+     * A free slot reserved by claim, published by commit and handed back when it goes out of scope uncommitted,
+     * with MutexPolicy the mutex is held for as long as the claim is
+     */
+    class Claim {
+    public:
+        Claim(Claim &&other) noexcept : buffer_(other.buffer_), slot_(other.slot_), built_(other.built_) {
+            other.buffer_ = nullptr;
+        }
+
+        Claim(const Claim &) = delete;
+
+        Claim &operator=(const Claim &) = delete;
+
+        ~Claim() {
+            if (buffer_ != nullptr) {
+                if (built_) {
+                    destroy(slot_, IsTrivial());
+                }
+                buffer_->policy_.abandon();
+            }
+        }
+
+        explicit operator bool() const { return slot_ != nullptr; }
+
+        T *get() const { return slot_; }
+
+        template<typename... Arguments>
+        T &emplace(Arguments &&... arguments) {
+            ::new(static_cast<void *>(slot_)) T(std::forward<Arguments>(arguments)...);
+            built_ = true;
+            return *slot_;
+        }
+
+        void commit() {
+            buffer_->policy_.commit(1);
+            buffer_ = nullptr;
+        }
+
+    private:
+        friend class BoundedBuffer;
+
+        Claim(BoundedBuffer *buffer, T *slot) : buffer_(buffer), slot_(slot), built_(false) {}
+
+        BoundedBuffer *buffer_;
+        T *slot_;
+        bool built_;
+    };
+
+    /***
+     * The oldest element granted by peek, destroyed and handed back by release and left in the buffer when the peek
+     * goes out of scope unreleased, with MutexPolicy the mutex is held for as long as the peek is
+     */
+    class Peek {
+    public:
+        Peek(Peek &&other) noexcept : buffer_(other.buffer_), slot_(other.slot_) {
+            other.buffer_ = nullptr;
+        }
+
+        Peek(const Peek &) = delete;
+
+        Peek &operator=(const Peek &) = delete;
+
+        ~Peek() {
+            if (buffer_ != nullptr) {
+                buffer_->policy_.abandon();
+            }
+        }
+
+        explicit operator bool() const { return slot_ != nullptr; }
+
+        T *get() const { return slot_; }
+
+        T &operator*() const { return *slot_; }
+
+        T *operator->() const { return slot_; }
+
+        void release() {
+            destroy(slot_, IsTrivial());
+            buffer_->policy_.release(1);
+            buffer_ = nullptr;
+        }
+
+    private:
+        friend class BoundedBuffer;
+
+        Peek(BoundedBuffer *buffer, T *slot) : buffer_(buffer), slot_(slot) {}
+
+        BoundedBuffer *buffer_;
+        T *slot_;
+    };
+
+    BoundedBuffer() = default;
+
+    BoundedBuffer(const BoundedBuffer &) = delete;
+
+    BoundedBuffer &operator=(const BoundedBuffer &) = delete;
+
+    ~BoundedBuffer() {
+        destroy_range(policy_.head(), policy_.tail() - policy_.head(), IsTrivial());
+    }
+
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    /***
+     * Append an element, waiting while the buffer is full
+     * @param item the element to append
+     */
+    void push(const T &item) {
+        emplace(item);
+    }
+
+    void push(T &&item) {
+        emplace(std::move(item));
+    }
+
+    /***
+     * Construct an element at the end of the buffer, waiting while the buffer is full
+     * @param arguments the arguments of the constructor of T
+     */
+    template<typename... Arguments>
+    void emplace(Arguments &&... arguments) {
+        Claim slot = claim();
+        slot.emplace(std::forward<Arguments>(arguments)...);
+        slot.commit();
+    }
+
+    /***
+     * Append an element without waiting
+     * @param item the element to append, left untouched when the buffer is full
+     * @return true if the element was appended, false if the buffer was full
+     */
+    bool try_push(const T &item) {
+        return try_emplace(item);
+    }
+
+    bool try_push(T &&item) {
+        return try_emplace(std::move(item));
+    }
+
+    template<typename... Arguments>
+    bool try_emplace(Arguments &&... arguments) {
+        Claim slot = try_claim();
+        if (!slot) {
+            return false;
+        }
+        slot.emplace(std::forward<Arguments>(arguments)...);
+        slot.commit();
+        return true;
+    }
+
+    /***
+     * Remove the oldest element, waiting while the buffer is empty
+     * @return the removed element
+     */
+    T pop() {
+        Peek oldest = peek();
+        T item(std::move(*oldest));
+        oldest.release();
+        return item;
+    }
+
+    /***
+     * Remove the oldest element without waiting
+     * @param item location the removed element is moved to
+     * @return true if an element was removed, false if the buffer was empty
+     */
+    bool try_pop(T &item) {
+        Peek oldest = try_peek();
+        if (!oldest) {
+            return false;
+        }
+        item = std::move(*oldest);
+        oldest.release();
+        return true;
+    }
+
+    /***
+     * Append all elements, waiting while the buffer is full and publishing each run that fits at once
+     * @param items the elements to append, copied
+     * @param count the number of elements
+     */
+    void push_batch(const T *items, std::size_t count) {
+        std::size_t position, granted;
+
+        while (count > 0) {
+            granted = policy_.claim(Capacity, count, position);
+            copy_in(position, items, granted, IsTrivial());
+            policy_.commit(granted);
+            items += granted;
+            count -= granted;
+        }
+    }
+
+    /***
+     * Remove every element that is available up to count, waiting while the buffer is empty
+     * @param items location the removed elements are moved to
+     * @param count the maximum number of elements
+     * @return the number of elements removed, at least 1 unless count is 0
+     */
+    std::size_t pop_batch(T *items, std::size_t count) {
+        std::size_t position, granted;
+
+        if (count == 0) {
+            return 0;
+        }
+        granted = policy_.peek(count, position);
+        move_out(position, items, granted, IsTrivial());
+        policy_.release(granted);
+        return granted;
+    }
+
+    /***
+     * Reserve the next free slot, waiting while the buffer is full. The caller constructs the element in the slot
+     * with emplace, or writes it through get when T is trivially copyable, and publishes it with commit. A claim
+     * that goes out of scope without a commit, for example because the constructor threw, hands the slot back and
+     * destroys an element emplace built in it
+     * @return the claim of the slot
+     */
+    Claim claim() {
+        std::size_t position;
+        policy_.claim(Capacity, 1, position);
+        return Claim(this, slot(position));
+    }
+
+    /***
+     * Reserve the next free slot without waiting
+     * @return the claim of the slot, empty if the buffer is full
+     */
+    Claim try_claim() {
+        std::size_t position;
+        return (policy_.try_claim(Capacity, 1, position) == 0) ? Claim(nullptr, nullptr) : Claim(this, slot(position));
+    }
+
+    /***
+     * Get the oldest element in place, waiting while the buffer is empty. The element stays in the buffer until the
+     * peek is released, a peek that goes out of scope without a release, for example because the reader threw,
+     * leaves the element in the buffer for the next consumer
+     * @return the peek of the oldest element
+     */
+    Peek peek() {
+        std::size_t position;
+        policy_.peek(1, position);
+        return Peek(this, slot(position));
+    }
+
+    /***
+     * Get the oldest element in place without waiting
+     * @return the peek of the oldest element, empty if the buffer is empty
+     */
+    Peek try_peek() {
+        std::size_t position;
+        return (policy_.try_peek(1, position) == 0) ? Peek(nullptr, nullptr) : Peek(this, slot(position));
+    }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+    T *slot(std::size_t position) {
+        return reinterpret_cast<T *>(&slots_[position & MASK]);
+    }
+
+    static void destroy(T *, std::true_type) {}
+
+    static void destroy(T *item, std::false_type) {
+        item->~T();
+    }
+
+    void destroy_range(std::size_t, std::size_t, std::true_type) {}
+
+    void destroy_range(std::size_t position, std::size_t count, std::false_type) {
+        for (; count > 0; position++, count--) {
+            slot(position)->~T();
+        }
+    }
+
+    /***
+     * Copy elements into consecutive positions, as one block on each side of the wrap for trivial types
+     */
+    void copy_in(std::size_t position, const T *items, std::size_t count, std::true_type) {
+        std::size_t first = SLOT_COUNT - (position & MASK);
+        first = (first < count) ? first : count;
+        std::memcpy(static_cast<void *>(slot(position)), items, sizeof(T) * first);
+        std::memcpy(static_cast<void *>(slot(0)), items + first, sizeof(T) * (count - first));
+    }
+
+    void copy_in(std::size_t position, const T *items, std::size_t count, std::false_type) {
+        std::size_t index = 0;
+
+        try {
+            for (; index < count; index++) {
+                ::new(static_cast<void *>(slot(position + index))) T(items[index]);
+            }
+        } catch (...) {
+            // an incomplete run is never published, so the elements built so far go with it
+            destroy_range(position, index, IsTrivial());
+            policy_.abandon();
+            throw;
+        }
+    }
+
+    /***
+     * Move elements out of consecutive positions, as one block on each side of the wrap for trivial types
+     */
+    void move_out(std::size_t position, T *items, std::size_t count, std::true_type) {
+        std::size_t first = SLOT_COUNT - (position & MASK);
+        first = (first < count) ? first : count;
+        std::memcpy(static_cast<void *>(items), slot(position), sizeof(T) * first);
+        std::memcpy(static_cast<void *>(items + first), slot(0), sizeof(T) * (count - first));
+    }
+
+    void move_out(std::size_t position, T *items, std::size_t count, std::false_type) {
+        std::size_t index = 0;
+
+        try {
+            for (; index < count; index++) {
+                items[index] = std::move(*slot(position + index));
+                slot(position + index)->~T();
+            }
+        } catch (...) {
+            // the elements moved out so far have left the buffer, the one that threw and the rest stay in it
+            policy_.release(index);
+            throw;
+        }
+    }
+
+    SyncPolicy policy_;
+    alignas(CACHE_LINE_SIZE) Storage slots_[SLOT_COUNT];
+};
+
+template<typename T, std::size_t Capacity, typename SyncPolicy>
+constexpr std::size_t BoundedBuffer<T, Capacity, SyncPolicy>::SLOT_COUNT;
+
+template<typename T, std::size_t Capacity, typename SyncPolicy>
+constexpr std::size_t BoundedBuffer<T, Capacity, SyncPolicy>::MASK;
+
+}
+
+#endif //BOUNDED_BUFFER_BOUNDED_BUFFER_HPP
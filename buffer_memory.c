@@ -0,0 +1,190 @@
+/***
+ * Page size and NUMA placement of buffer storage
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <linux/mempolicy.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "buffer_memory.h"
+
+#define DEFAULT_HUGE_PAGE_SIZE (2UL << 20)
+
+/***
+ * The largest number of nodes a kernel can be built with, the number of bits of the node mask passed to mbind
+ */
+#define MAX_NODES 1024
+#define NODE_MASK_BITS (sizeof(unsigned long) * 8)
+
+/***
+ * The configured policy
+ */
+static buffer_memory_policy_t configured_policy = {BUFFER_PAGES_DEFAULT, 0, -1};
+
+/***
+ * Get the size of the default huge page of the system
+ * @return the size in bytes
+ */
+static size_t huge_page_size(void) {
+    static size_t size = 0;
+    char line[128];
+    unsigned long kilobytes;
+    FILE *meminfo;
+
+    if (size == 0) {
+        size = DEFAULT_HUGE_PAGE_SIZE;
+        meminfo = fopen("/proc/meminfo", "r");
+        if (meminfo != NULL) {
+            while (fgets(line, sizeof(line), meminfo) != NULL) {
+                if (sscanf(line, "Hugepagesize: %lu kB", &kilobytes) == 1) {
+                    size = (size_t) kilobytes << 10;
+                    break;
+                }
+            }
+            fclose(meminfo);
+        }
+    }
+    return size;
+}
+
+/***
+ * Get the size of the pages of the configured policy
+ * @return the size in bytes
+ */
+static size_t page_size(void) {
+    return (configured_policy.pages == BUFFER_PAGES_DEFAULT) ? (size_t) sysconf(_SC_PAGESIZE) : huge_page_size();
+}
+
+/***
+ * Get the size of the mapping of a buffer, a whole number of pages
+ * @param size the size of the buffer in bytes
+ * @return the size of the mapping in bytes
+ */
+static size_t mapping_size(size_t size) {
+    size_t page = page_size();
+    return (size + page - 1) & ~(page - 1);
+}
+
+void buffer_memory_configure(const buffer_memory_policy_t *policy) {
+    configured_policy = *policy;
+}
+
+int buffer_memory_parse(const char *options, buffer_memory_policy_t *policy) {
+    char copy[256], *token, *state, *end;
+    long node;
+
+    if (strlen(options) >= sizeof(copy)) {
+        return EINVAL;
+    }
+    strcpy(copy, options);
+
+    policy->pages = BUFFER_PAGES_DEFAULT;
+    policy->prefault = 0;
+    policy->node = -1;
+    for (token = strtok_r(copy, ",", &state); token != NULL; token = strtok_r(NULL, ",", &state)) {
+        if (strcmp(token, "hugetlb") == 0) {
+            policy->pages = BUFFER_PAGES_HUGETLB;
+        } else if (strcmp(token, "thp") == 0) {
+            policy->pages = BUFFER_PAGES_TRANSPARENT;
+        } else if (strcmp(token, "prefault") == 0) {
+            policy->prefault = 1;
+        } else if (strncmp(token, "node=", 5) == 0) {
+            node = strtol(token + 5, &end, 10);
+            if (end == token + 5 || *end != '\0' || node < 0 || node >= MAX_NODES) {
+                return EINVAL;
+            }
+            policy->node = (int) node;
+        } else {
+            return EINVAL;
+        }
+    }
+    return 0;
+}
+
+/***
+ * Map memory aligned to the huge page size, so that the kernel can back all of it with transparent huge pages
+ * @param size the size of the mapping, a multiple of the huge page size
+ * @return the address of the mapping, MAP_FAILED on failure
+ */
+static void *map_aligned(size_t size) {
+    size_t alignment = huge_page_size(), head, tail;
+    char *address = (char *) mmap(NULL, size + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                                  0);
+    if (address == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+
+    // map one huge page more than needed and give back what lies before and after the aligned range
+    head = (alignment - ((uintptr_t) address & (alignment - 1))) & (alignment - 1);
+    tail = alignment - head;
+    if (head > 0) {
+        munmap(address, head);
+    }
+    if (tail > 0) {
+        munmap(address + head + size, tail);
+    }
+    return address + head;
+}
+
+int buffer_memory_allocate(void **memory, size_t size) {
+    size_t length = mapping_size(size), page = page_size(), offset;
+    unsigned long node_mask[MAX_NODES / NODE_MASK_BITS];
+    char *address;
+    int error_code;
+
+    if (configured_policy.pages == BUFFER_PAGES_TRANSPARENT) {
+        address = (char *) map_aligned(length);
+    } else {
+        address = (char *) mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS |
+                                (configured_policy.pages == BUFFER_PAGES_HUGETLB ? MAP_HUGETLB : 0), -1, 0);
+    }
+    if (address == MAP_FAILED) {
+        return errno;
+    }
+
+    if (configured_policy.pages == BUFFER_PAGES_TRANSPARENT && madvise(address, length, MADV_HUGEPAGE) != 0) {
+        error_code = errno;
+        munmap(address, length);
+        return error_code;
+    }
+
+    // a node found by thread_placement_node rather than parsed may be past the mask
+    if (configured_policy.node >= MAX_NODES) {
+        munmap(address, length);
+        return EINVAL;
+    }
+
+    // nothing is faulted in yet, so binding the range places every page on the node
+    if (configured_policy.node >= 0) {
+        memset(node_mask, 0, sizeof(node_mask));
+        node_mask[configured_policy.node / NODE_MASK_BITS] = 1UL << (configured_policy.node % NODE_MASK_BITS);
+        if (syscall(SYS_mbind, address, length, MPOL_BIND, node_mask, MAX_NODES + 1, 0) != 0) {
+            error_code = errno;
+            munmap(address, length);
+            return error_code;
+        }
+    }
+
+    if (configured_policy.prefault) {
+        for (offset = 0; offset < length; offset += page) {
+            ((volatile char *) address)[offset] = 0;
+        }
+    }
+
+    *memory = address;
+    return 0;
+}
+
+void buffer_memory_free(void *memory, size_t size) {
+    if (memory != NULL) {
+        munmap(memory, mapping_size(size));
+    }
+}
@@ -0,0 +1,77 @@
+/***
+ * Page size and NUMA placement of buffer storage
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * The slots of the rings and queues are mapped with mmap instead of taken from the heap, so that the pages backing
+ * them can be chosen. A large ring on 4 KiB pages needs a TLB entry for every 4 KiB it touches, and pages faulted
+ * in by whichever thread happened to write them first may sit on a remote node.
+ *
+ * The policy is process wide and applies to every buffer allocated after it is configured:
+ *
+ *  - BUFFER_PAGES_HUGETLB maps explicit huge pages with MAP_HUGETLB, which fails unless the administrator reserved
+ *    enough of them in /proc/sys/vm/nr_hugepages
+ *  - BUFFER_PAGES_TRANSPARENT aligns the mapping to the huge page size and asks for transparent huge pages with
+ *    madvise, the kernel falls back to small pages when it cannot find a huge one
+ *  - prefault writes every page right after the mapping is created, so no thread takes a page fault when it first
+ *    touches a slot
+ *  - node binds the pages to a NUMA node with mbind before they are faulted in
+ *
+ * With a huge page policy every buffer takes at least one huge page, which is only worth it for large buffers.
+ */
+
+#ifndef BOUNDED_BUFFER_BUFFER_MEMORY_H
+#define BOUNDED_BUFFER_BUFFER_MEMORY_H
+
+#include <stddef.h>
+
+/***
+ * The kind of pages buffers are mapped with
+ */
+typedef enum {
+    BUFFER_PAGES_DEFAULT,
+    BUFFER_PAGES_TRANSPARENT,
+    BUFFER_PAGES_HUGETLB
+} buffer_pages_t;
+
+/***
+ * How buffers are allocated, node is -1 to leave the placement to the first thread that touches a page
+ */
+typedef struct buffer_memory_policy {
+    buffer_pages_t pages;
+    int prefault;
+    int node;
+} buffer_memory_policy_t;
+
+/***
+ * Set the policy of the buffers allocated from now on, must not be called while a buffer is allocated since the
+ * size of its mapping depends on the policy
+ * @param policy the policy
+ */
+void buffer_memory_configure(const buffer_memory_policy_t *policy);
+
+/***
+ * Parse a comma separated policy out of hugetlb, thp, prefault and node=N, the default policy is used for
+ * anything not mentioned
+ * @param options the options to parse
+ * @param policy location where the policy is stored
+ * @return 0 on success, EINVAL if an option is not valid
+ */
+int buffer_memory_parse(const char *options, buffer_memory_policy_t *policy);
+
+/***
+ * Map zero filled memory for a buffer with the configured policy
+ * @param memory location where the address of the memory is stored
+ * @param size the size in bytes
+ * @return 0 on success, an error number otherwise
+ */
+int buffer_memory_allocate(void **memory, size_t size);
+
+/***
+ * Unmap the memory of a buffer
+ * @param memory the memory, may be NULL
+ * @param size the size it was allocated with
+ */
+void buffer_memory_free(void *memory, size_t size);
+
+#endif //BOUNDED_BUFFER_BUFFER_MEMORY_H
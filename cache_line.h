@@ -0,0 +1,21 @@
+/***
+ * Cache line layout helpers
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#ifndef BOUNDED_BUFFER_CACHE_LINE_H
+#define BOUNDED_BUFFER_CACHE_LINE_H
+
+/***
+ * The size of a cache line, 128 on processors whose adjacent line prefetcher pulls lines in pairs would also work
+ * but doubles the footprint of every control block
+ */
+#define CACHE_LINE_SIZE 64
+
+/***
+ * Start a member or variable on its own cache line, the next member aligned this way ends the line
+ */
+#define CACHE_LINE_ALIGNED _Alignas(CACHE_LINE_SIZE)
+
+#endif //BOUNDED_BUFFER_CACHE_LINE_H
@@ -0,0 +1,396 @@
+/***
+ * Core-to-core handoff latency probe and placement autotuner
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cache_line.h"
+#include "core_latency.h"
+#include "thread_placement.h"
+#include "wait_strategy.h"
+
+#define PROBE_SAMPLES 5
+#define PROBE_ABORT ULLONG_MAX
+
+/***
+ * The state of the probe of one pair of CPUs, the counter is on a cache line of its own and only the initiator
+ * writes the result
+ */
+typedef struct probe {
+    CACHE_LINE_ALIGNED atomic_ullong counter;
+    CACHE_LINE_ALIGNED unsigned int round_trips;
+    double nanoseconds;
+} probe_t;
+
+/***
+ * Read the monotonic clock
+ * @return the current time in nanoseconds
+ */
+static uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ULL + (uint64_t) time.tv_nsec;
+}
+
+/***
+ * Wait until the counter of a probe reaches a value
+ * @param probe the probe
+ * @param expected the value
+ * @return 1 once the value is reached, 0 if the probe was aborted
+ */
+static int await_counter(probe_t *probe, unsigned long long expected) {
+    unsigned long long value;
+
+    while ((value = atomic_load_explicit(&probe->counter, memory_order_acquire)) != expected) {
+        if (value == PROBE_ABORT) {
+            return 0;
+        }
+        cpu_relax();
+    }
+    return 1;
+}
+
+/***
+ * The thread that answers every odd value of the counter with the next even one
+ * @param context the probe
+ * @return NULL
+ */
+static void *respond(void *context) {
+    probe_t *probe = (probe_t *) context;
+    unsigned long long trip, trips = (unsigned long long) probe->round_trips * PROBE_SAMPLES;
+
+    for (trip = 0; trip < trips; trip++) {
+        if (!await_counter(probe, 2 * trip + 1)) {
+            return NULL;
+        }
+        atomic_store_explicit(&probe->counter, 2 * trip + 2, memory_order_release);
+    }
+    return NULL;
+}
+
+/***
+ * The thread that starts every round trip and times the samples, keeping the fastest
+ * @param context the probe
+ * @return NULL
+ */
+static void *initiate(void *context) {
+    probe_t *probe = (probe_t *) context;
+    unsigned long long trip = 0;
+    unsigned int sample, round_trip;
+    uint64_t start;
+    double nanoseconds;
+
+    probe->nanoseconds = DBL_MAX;
+    for (sample = 0; sample < PROBE_SAMPLES; sample++) {
+        start = now_ns();
+        for (round_trip = 0; round_trip < probe->round_trips; round_trip++, trip++) {
+            atomic_store_explicit(&probe->counter, 2 * trip + 1, memory_order_release);
+            await_counter(probe, 2 * trip + 2);
+        }
+        // a round trip moves the line there and back
+        nanoseconds = (double) (now_ns() - start) / probe->round_trips / 2;
+        if (nanoseconds < probe->nanoseconds) {
+            probe->nanoseconds = nanoseconds;
+        }
+    }
+    return NULL;
+}
+
+/***
+ * Start a probe thread pinned to a CPU
+ * @param thread location where the handle of the thread is stored
+ * @param cpu the CPU
+ * @param function the function of the thread
+ * @param probe the probe
+ * @return 0 on success, an error number otherwise
+ */
+static int start_probe_thread(pthread_t *thread, int cpu, void *(*function)(void *), probe_t *probe) {
+    thread_schedule_t schedule = {-1, 0};
+    pthread_attr_t attr;
+    int error_code = pthread_attr_init(&attr);
+
+    if (error_code != 0) {
+        return error_code;
+    }
+    error_code = thread_placement_configure_attr(&attr, cpu, &schedule);
+    if (error_code == 0) {
+        error_code = pthread_create(thread, &attr, function, probe);
+    }
+    pthread_attr_destroy(&attr);
+    return error_code;
+}
+
+/***
+ * Measure the latency between two CPUs
+ * @param first the CPU of the initiator
+ * @param second the CPU of the responder
+ * @param round_trips the number of round trips of every sample
+ * @param nanoseconds location where the one way latency is stored
+ * @return 0 on success, an error number otherwise
+ */
+static int probe_pair(int first, int second, unsigned int round_trips, double *nanoseconds) {
+    pthread_t initiator, responder;
+    probe_t probe;
+    int error_code;
+
+    atomic_init(&probe.counter, 0);
+    probe.round_trips = round_trips;
+
+    error_code = start_probe_thread(&responder, second, respond, &probe);
+    if (error_code != 0) {
+        return error_code;
+    }
+    error_code = start_probe_thread(&initiator, first, initiate, &probe);
+    if (error_code != 0) {
+        // release the responder, which waits for a round trip that never starts
+        atomic_store_explicit(&probe.counter, PROBE_ABORT, memory_order_release);
+        pthread_join(responder, NULL);
+        return error_code;
+    }
+
+    pthread_join(initiator, NULL);
+    pthread_join(responder, NULL);
+    *nanoseconds = probe.nanoseconds;
+    return 0;
+}
+
+/***
+ * Allocate the storage of a matrix
+ * @param matrix the matrix
+ * @param count the number of CPUs
+ * @return 0 on success, an error number otherwise
+ */
+static int allocate(core_latency_matrix_t *matrix, int count) {
+    matrix->count = count;
+    matrix->cpus = (int *) malloc(sizeof(int) * count);
+    matrix->nanoseconds = (double *) calloc((size_t) count * count, sizeof(double));
+    if (matrix->cpus == NULL || matrix->nanoseconds == NULL) {
+        core_latency_destroy(matrix);
+        return ENOMEM;
+    }
+    return 0;
+}
+
+int core_latency_measure(core_latency_matrix_t *matrix, unsigned int round_trips) {
+    cpu_set_t allowed;
+    int cpu, first, second, count = 0, error_code;
+    double nanoseconds;
+
+    if (round_trips == 0) {
+        return EINVAL;
+    }
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return errno;
+    }
+    error_code = allocate(matrix, CPU_COUNT(&allowed));
+    if (error_code != 0) {
+        return error_code;
+    }
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            matrix->cpus[count++] = cpu;
+        }
+    }
+
+    // a round trip covers both directions, so every pair is measured once
+    for (first = 0; first < count; first++) {
+        for (second = first + 1; second < count; second++) {
+            error_code = probe_pair(matrix->cpus[first], matrix->cpus[second], round_trips, &nanoseconds);
+            if (error_code != 0) {
+                core_latency_destroy(matrix);
+                return error_code;
+            }
+            matrix->nanoseconds[first * count + second] = nanoseconds;
+            matrix->nanoseconds[second * count + first] = nanoseconds;
+        }
+    }
+    return 0;
+}
+
+int core_latency_load(core_latency_matrix_t *matrix, const char *path) {
+    cpu_set_t allowed;
+    FILE *file;
+    int count, index, error_code = 0;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return errno;
+    }
+    file = fopen(path, "r");
+    if (file == NULL) {
+        return errno;
+    }
+
+    if (fscanf(file, "cpus %d", &count) != 1 || count < 1 || count > CPU_SETSIZE) {
+        fclose(file);
+        return EINVAL;
+    }
+    error_code = allocate(matrix, count);
+    if (error_code != 0) {
+        fclose(file);
+        return error_code;
+    }
+
+    // a matrix of another machine or of CPUs the process may no longer use would place threads wrongly
+    for (index = 0; index < count && error_code == 0; index++) {
+        if (fscanf(file, "%d", &matrix->cpus[index]) != 1 || matrix->cpus[index] < 0 ||
+            matrix->cpus[index] >= CPU_SETSIZE || !CPU_ISSET(matrix->cpus[index], &allowed)) {
+            error_code = EINVAL;
+        }
+    }
+    for (index = 0; index < count * count && error_code == 0; index++) {
+        if (fscanf(file, "%lf", &matrix->nanoseconds[index]) != 1 || matrix->nanoseconds[index] < 0) {
+            error_code = EINVAL;
+        }
+    }
+    fclose(file);
+
+    if (error_code != 0) {
+        core_latency_destroy(matrix);
+    }
+    return error_code;
+}
+
+int core_latency_save(const core_latency_matrix_t *matrix, const char *path) {
+    FILE *file = fopen(path, "w");
+    int first, second;
+
+    if (file == NULL) {
+        return errno;
+    }
+    fprintf(file, "cpus %d\n", matrix->count);
+    for (first = 0; first < matrix->count; first++) {
+        fprintf(file, "%s%d", (first == 0) ? "" : " ", matrix->cpus[first]);
+    }
+    fprintf(file, "\n");
+    for (first = 0; first < matrix->count; first++) {
+        for (second = 0; second < matrix->count; second++) {
+            fprintf(file, "%s%.1f", (second == 0) ? "" : " ", matrix->nanoseconds[first * matrix->count + second]);
+        }
+        fprintf(file, "\n");
+    }
+    return (fclose(file) == 0) ? 0 : errno;
+}
+
+void core_latency_print(const core_latency_matrix_t *matrix, FILE *stream) {
+    int first, second;
+
+    fprintf(stream, "Core-to-core latency in ns\n%6s", "");
+    for (second = 0; second < matrix->count; second++) {
+        fprintf(stream, " %6d", matrix->cpus[second]);
+    }
+    fprintf(stream, "\n");
+    for (first = 0; first < matrix->count; first++) {
+        fprintf(stream, "%6d", matrix->cpus[first]);
+        for (second = 0; second < matrix->count; second++) {
+            fprintf(stream, " %6.1f", matrix->nanoseconds[first * matrix->count + second]);
+        }
+        fprintf(stream, "\n");
+    }
+}
+
+/***
+ * Take the unused CPU closest to a partner, all CPUs become unused again once every one of them is taken
+ * @param matrix the matrix
+ * @param used the CPUs taken so far, by index into the matrix
+ * @param partner the index of the partner
+ * @return the index of the CPU
+ */
+static int take_closest(const core_latency_matrix_t *matrix, char *used, int partner) {
+    const double *latencies = matrix->nanoseconds + partner * matrix->count;
+    int index, best = -1, pass;
+
+    // with a single CPU every thread shares it
+    if (matrix->count == 1) {
+        return 0;
+    }
+
+    for (pass = 0; pass < 2 && best < 0; pass++) {
+        if (pass == 1) {
+            memset(used, 0, matrix->count);
+        }
+        for (index = 0; index < matrix->count; index++) {
+            if (!used[index] && index != partner && (best < 0 || latencies[index] < latencies[best])) {
+                best = index;
+            }
+        }
+    }
+    used[best] = 1;
+    return best;
+}
+
+int core_latency_place(const core_latency_matrix_t *matrix, int *cpus, int producer_count, int consumer_count) {
+    int *indices, pair, first, second, best_first, best_second, free_count, index;
+    char *used;
+
+    indices = (int *) malloc(sizeof(int) * (producer_count + consumer_count));
+    used = (char *) calloc(matrix->count, sizeof(char));
+    if (indices == NULL || used == NULL) {
+        free(indices);
+        free(used);
+        return ENOMEM;
+    }
+
+    // each producer and its consumer take the closest pair of unused CPUs
+    for (pair = 0; pair < producer_count && pair < consumer_count; pair++) {
+        for (free_count = 0, index = 0; index < matrix->count; index++) {
+            free_count += !used[index];
+        }
+        if (free_count < 2) {
+            memset(used, 0, matrix->count);
+        }
+
+        best_first = 0;
+        best_second = (matrix->count > 1) ? 1 : 0;
+        for (first = 0; first < matrix->count; first++) {
+            for (second = 0; second < matrix->count; second++) {
+                if (first != second && !used[first] && !used[second] &&
+                    ((used[best_first] || used[best_second]) ||
+                     matrix->nanoseconds[first * matrix->count + second] <
+                     matrix->nanoseconds[best_first * matrix->count + best_second])) {
+                    best_first = first;
+                    best_second = second;
+                }
+            }
+        }
+        used[best_first] = 1;
+        used[best_second] = 1;
+        indices[pair] = best_first;
+        indices[producer_count + pair] = best_second;
+    }
+
+    // every extra producer or consumer goes next to the partner it shares the most items with
+    for (index = pair; index < producer_count; index++) {
+        indices[index] = take_closest(matrix, used, indices[producer_count + index % consumer_count]);
+    }
+    for (index = pair; index < consumer_count; index++) {
+        indices[producer_count + index] = take_closest(matrix, used, indices[index % producer_count]);
+    }
+
+    for (index = 0; index < producer_count + consumer_count; index++) {
+        cpus[index] = matrix->cpus[indices[index]];
+    }
+    free(indices);
+    free(used);
+    return 0;
+}
+
+void core_latency_destroy(core_latency_matrix_t *matrix) {
+    free(matrix->cpus);
+    free(matrix->nanoseconds);
+    matrix->cpus = NULL;
+    matrix->nanoseconds = NULL;
+    matrix->count = 0;
+}
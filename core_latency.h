@@ -0,0 +1,85 @@
+/***
+ * Core-to-core handoff latency probe and placement autotuner
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Every item moves from the producer's core to the consumer's core as a cache line that one core writes and the
+ * other then reads, so the cost of a handoff is the time a line takes to travel between the two cores. It depends
+ * on whether the cores share a cache, which slice of the last level cache owns the line, and which socket each
+ * core is on, and it differs from machine to machine in ways the topology in sysfs does not fully describe.
+ *
+ * The probe measures it directly: for every pair of CPUs the process may run on, a thread pinned to each CPU
+ * bounces a counter on a cache line of its own back and forth, and the time of a round trip divided by two is the
+ * one way latency. Every pair is sampled several times and the fastest sample is kept, which filters out
+ * interrupts and migrations of other work. The matrix can be saved to a file and loaded on the next start instead
+ * of being measured again.
+ *
+ * The autotuner places producer i and consumer i on the pair of unused CPUs with the lowest latency, then every
+ * extra producer or consumer on the unused CPU closest to its partner, and reuses CPUs once every CPU has a thread.
+ */
+
+#ifndef BOUNDED_BUFFER_CORE_LATENCY_H
+#define BOUNDED_BUFFER_CORE_LATENCY_H
+
+#include <stdio.h>
+
+#define DEFAULT_PROBE_ROUND_TRIPS 1000
+
+/***
+ * The one way latency between every pair of CPUs, nanoseconds[i * count + j] is the latency from cpus[i] to cpus[j]
+ */
+typedef struct core_latency_matrix {
+    int count;
+    int *cpus;
+    double *nanoseconds;
+} core_latency_matrix_t;
+
+/***
+ * Measure the latency between every pair of the CPUs the process may run on
+ * @param matrix the matrix to initialize
+ * @param round_trips the number of round trips of every sample
+ * @return 0 on success, an error number otherwise
+ */
+int core_latency_measure(core_latency_matrix_t *matrix, unsigned int round_trips);
+
+/***
+ * Load a matrix saved by core_latency_save
+ * @param matrix the matrix to initialize
+ * @param path the path of the file
+ * @return 0 on success, EINVAL if the file is not a matrix of CPUs the process may run on, another error number
+ * otherwise
+ */
+int core_latency_load(core_latency_matrix_t *matrix, const char *path);
+
+/***
+ * Save a matrix to a file
+ * @param matrix the matrix
+ * @param path the path of the file
+ * @return 0 on success, an error number otherwise
+ */
+int core_latency_save(const core_latency_matrix_t *matrix, const char *path);
+
+/***
+ * Print a matrix as a table with a row per source CPU
+ * @param matrix the matrix
+ * @param stream the stream to print to
+ */
+void core_latency_print(const core_latency_matrix_t *matrix, FILE *stream);
+
+/***
+ * Place producers and consumers so that every producer hands over to its consumer with the lowest latency
+ * @param matrix the measured matrix
+ * @param cpus location where the CPUs of the producers followed by those of the consumers are stored
+ * @param producer_count the number of producers, at least 1
+ * @param consumer_count the number of consumers, at least 1
+ * @return 0 on success, an error number otherwise
+ */
+int core_latency_place(const core_latency_matrix_t *matrix, int *cpus, int producer_count, int consumer_count);
+
+/***
+ * Release the storage held by a matrix
+ * @param matrix the matrix to release
+ */
+void core_latency_destroy(core_latency_matrix_t *matrix);
+
+#endif //BOUNDED_BUFFER_CORE_LATENCY_H
@@ -0,0 +1,64 @@
+/***
+ * Readiness notification of a buffer through an eventfd
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "event_notifier.h"
+
+int event_notifier_init(event_notifier_t *notifier) {
+    // non-blocking so that clearing an eventfd that was never written returns at once
+    notifier->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (notifier->fd < 0) {
+        return errno;
+    }
+
+    atomic_init(&notifier->armed, 1);
+    atomic_init(&notifier->signals, 0);
+    return 0;
+}
+
+int event_notifier_destroy(event_notifier_t *notifier) {
+    if (close(notifier->fd) != 0) {
+        return errno;
+    }
+    notifier->fd = -1;
+    return 0;
+}
+
+void event_notifier_signal(event_notifier_t *notifier) {
+    uint64_t value = 1;
+    ssize_t result;
+
+    // orders the publication of the item before the load of armed, pairs with the fence in event_notifier_arm
+    atomic_thread_fence(memory_order_seq_cst);
+
+    // only the producer that disarms the notifier writes, so a burst costs one system call
+    if (atomic_load_explicit(&notifier->armed, memory_order_relaxed) &&
+        atomic_exchange_explicit(&notifier->armed, 0, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&notifier->signals, 1, memory_order_relaxed);
+        do {
+            result = write(notifier->fd, &value, sizeof(value));
+        } while (result < 0 && errno == EINTR);
+    }
+}
+
+void event_notifier_arm(event_notifier_t *notifier) {
+    uint64_t value;
+    ssize_t result;
+
+    // clear a signal the consumer has already acted on, so epoll only reports the next transition
+    do {
+        result = read(notifier->fd, &value, sizeof(value));
+    } while (result < 0 && errno == EINTR);
+
+    // orders the store of armed before the consumer's next look at the buffer, pairs with the fence in
+    // event_notifier_signal
+    atomic_store_explicit(&notifier->armed, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
@@ -0,0 +1,62 @@
+/***
+ * Readiness notification of a buffer through an eventfd
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * A consumer that also services sockets and timers cannot block in a semaphore or on a futex, it has to wait in
+ * epoll. The notifier gives a buffer an eventfd that becomes readable when items are available, so one event loop
+ * can wait on many buffers and file descriptors together.
+ *
+ * Writing the eventfd for every item would cost a system call per item. The notifier only writes it on the
+ * transition from empty to non-empty as the consumer saw it: the consumer arms the notifier once it finds the
+ * buffer empty and the first producer to publish after that disarms it and writes the eventfd, every later item
+ * costs the producer a fence and a load. Arming clears the eventfd first, and the consumer must try the buffer once
+ * more after arming, since an item published just before the notifier was armed does not signal it. Both sides
+ * order their store before the other side's flag with a full fence, the same handshake as wait_parker_notify, so
+ * either the producer sees the notifier armed or the consumer sees the item.
+ */
+
+#ifndef BOUNDED_BUFFER_EVENT_NOTIFIER_H
+#define BOUNDED_BUFFER_EVENT_NOTIFIER_H
+
+#include <stdatomic.h>
+
+#include "cache_line.h"
+
+/***
+ * The notifier, armed is 1 while the consumer waits for the eventfd and signals counts the writes to it
+ */
+typedef struct event_notifier {
+    int fd;
+    CACHE_LINE_ALIGNED atomic_int armed;
+    atomic_ullong signals;
+} event_notifier_t;
+
+/***
+ * Create the eventfd of a notifier, the notifier starts armed since the buffer starts empty
+ * @param notifier the notifier to initialize
+ * @return 0 on success, an error number otherwise
+ */
+int event_notifier_init(event_notifier_t *notifier);
+
+/***
+ * Close the eventfd of a notifier
+ * @param notifier the notifier to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int event_notifier_destroy(event_notifier_t *notifier);
+
+/***
+ * Write the eventfd if the consumer armed the notifier, must be called after an item was published
+ * @param notifier the notifier
+ */
+void event_notifier_signal(event_notifier_t *notifier);
+
+/***
+ * Clear the eventfd and arm the notifier, called by the consumer once it found the buffer empty, which it must
+ * then try once more before waiting for the eventfd
+ * @param notifier the notifier
+ */
+void event_notifier_arm(event_notifier_t *notifier);
+
+#endif //BOUNDED_BUFFER_EVENT_NOTIFIER_H
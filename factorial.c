@@ -0,0 +1,61 @@
+/***
+ * Factorial kernels used to produce items
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <string.h>
+
+#include "factorial.h"
+#include "factorial_table.h"
+
+long double factorial(unsigned int number) {
+    unsigned int factor;
+    long double result;
+
+    if (number < FACTORIAL_TABLE_SIZE) {
+        return factorial_table[number];
+    }
+
+    // continue the product from the last entry of the table, it overflows on the first multiplication
+    result = factorial_table[FACTORIAL_TABLE_SIZE - 1];
+    for (factor = FACTORIAL_TABLE_SIZE; factor <= number; factor++) {
+        result *= factor;
+    }
+    return result;
+}
+
+void factorial_batch(long double *results, unsigned int first, size_t count, unsigned int modulus) {
+    size_t run, copied, index;
+
+    while (count > 0) {
+        // the arguments up to the wrap are consecutive, the part of them inside the table is one contiguous copy
+        run = (count < modulus - first) ? count : modulus - first;
+        copied = (first >= FACTORIAL_TABLE_SIZE) ? 0 : (run < FACTORIAL_TABLE_SIZE - first) ?
+                                                       run : FACTORIAL_TABLE_SIZE - first;
+        memcpy(results, &factorial_table[first], sizeof(long double) * copied);
+
+        // beyond the table every result is the one before it times its argument
+        for (index = copied; index < run; index++) {
+            results[index] = (index == 0) ? factorial(first) : results[index - 1] * (long double) (first + index);
+        }
+
+        results += run;
+        count -= run;
+        first = 0;
+    }
+}
+
+long double factorial_iterative(unsigned int number) {
+    unsigned int factor;
+    long double result = 1;
+
+    for (factor = 2; factor <= number; factor++) {
+        result *= factor;
+    }
+    return result;
+}
+
+long double factorial_recursive(unsigned int number) {
+    return (number == 0) ? 1 : number * factorial_recursive(number - 1);
+}
@@ -0,0 +1,50 @@
+/***
+ * Factorial kernels used to produce items
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * factorial looks the result up in a table generated at build time for every argument whose factorial is finite
+ * in long double (0 to 1754) and falls back to an iterative product beyond it. factorial_recursive is the original
+ * implementation of produce_item, kept as a reference for the benchmarks. All three return bit for bit the same
+ * values.
+ *
+ * factorial_batch fills a block of results for consecutive arguments at once. Runs of arguments inside the table
+ * are a single memcpy out of it, which the C library vectorizes with the widest instructions the CPU supports.
+ */
+
+#ifndef BOUNDED_BUFFER_FACTORIAL_H
+#define BOUNDED_BUFFER_FACTORIAL_H
+
+#include <stddef.h>
+
+/***
+ * Compute a factorial with the lookup table, falling back to the iterative product outside of it
+ * @param number the argument
+ * @return number!, infinity once it overflows long double
+ */
+long double factorial(unsigned int number);
+
+/***
+ * Compute the factorials of consecutive arguments that wrap around to 0 at a modulus
+ * @param results the array the factorials are stored in
+ * @param first the first argument, less than modulus
+ * @param count the number of factorials
+ * @param modulus the argument that follows modulus - 1 is 0
+ */
+void factorial_batch(long double *results, unsigned int first, size_t count, unsigned int modulus);
+
+/***
+ * Compute a factorial by multiplying in ascending order
+ * @param number the argument
+ * @return number!, infinity once it overflows long double
+ */
+long double factorial_iterative(unsigned int number);
+
+/***
+ * Compute a factorial recursively, one stack frame per multiplication
+ * @param number the argument
+ * @return number!, infinity once it overflows long double
+ */
+long double factorial_recursive(unsigned int number);
+
+#endif //BOUNDED_BUFFER_FACTORIAL_H
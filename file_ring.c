@@ -0,0 +1,429 @@
+/***
+ * Persistent single-producer/single-consumer ring buffer backed by a memory-mapped file
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "file_ring.h"
+#include "ring_math.h"
+
+/***
+ * Context of a blocking operation
+ */
+typedef struct item_context {
+    file_ring_t *ring;
+    long double *item;
+} item_context_t;
+
+/***
+ * Read the monotonic clock
+ * @return the current time in nanoseconds
+ */
+static uint64_t now_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t) time.tv_sec * 1000000000ULL + (uint64_t) time.tv_nsec;
+}
+
+/***
+ * Write back the pages that hold a range of bytes of the mapping
+ * @param ring the ring
+ * @param first the first byte of the range
+ * @param end the byte past the end of the range
+ * @return 0 on success, an error number otherwise
+ */
+static int sync_range(file_ring_t *ring, const void *first, const void *end) {
+    // msync takes a page aligned address, the length is rounded up by the kernel
+    char *start = (char *) ((uintptr_t) first & ~(uintptr_t) (ring->page_size - 1));
+    return (msync(start, (size_t) ((const char *) end - start), MS_SYNC) == 0) ? 0 : errno;
+}
+
+/***
+ * Write back the slots of a range of indices
+ * @param ring the ring
+ * @param first the first index of the range
+ * @param last the index past the end of the range
+ * @return 0 on success, an error number otherwise
+ */
+static int sync_slots(file_ring_t *ring, unsigned long long first, unsigned long long last) {
+    unsigned long long mask = ring->header->mask;
+    size_t first_slot = (size_t) (first & mask), end_slot = (size_t) ((last - 1) & mask) + 1;
+    int error_code;
+
+    if (first == last) {
+        return 0;
+    }
+
+    // a range that wraps around the end of the storage is written back in two pieces
+    if (last - first > mask || first_slot >= end_slot) {
+        error_code = sync_range(ring, ring->slots + first_slot, ring->slots + mask + 1);
+        if (error_code != 0 || last - first > mask) {
+            return (error_code != 0) ? error_code : sync_range(ring, ring->slots, ring->slots + first_slot);
+        }
+        first_slot = 0;
+    }
+    return sync_range(ring, ring->slots + first_slot, ring->slots + end_slot);
+}
+
+/***
+ * Record the first error of a write back
+ * @param ring the ring
+ * @param error_code the result of the write back
+ */
+static void record_error(file_ring_t *ring, int error_code) {
+    if (error_code != 0 && ring->sync_error == 0) {
+        ring->sync_error = error_code;
+    }
+}
+
+/***
+ * Write back the header page, and with it the head the consumer had stored before, which becomes the durable head
+ * @param ring the ring
+ * @return 0 on success, an error number otherwise
+ */
+static int sync_header(file_ring_t *ring) {
+    unsigned long long head = atomic_load_explicit(&ring->header->head, memory_order_acquire);
+    int error_code = sync_range(ring, ring->header, (const char *) ring->header + FILE_RING_HEADER_SIZE);
+
+    if (error_code == 0) {
+        ring->durable_head = head;
+    }
+    return error_code;
+}
+
+/***
+ * Commit the published items up to an index: write back their slots, then store the index as the tail of the
+ * header and write back the header, so the tail in the file never covers a slot that is not in the file
+ * @param ring the ring
+ * @param tail the index past the last item to commit
+ */
+static void commit(file_ring_t *ring, unsigned long long tail) {
+    int error_code = 0;
+
+    if (ring->sync != FILE_RING_SYNC_NONE) {
+        error_code = sync_slots(ring, ring->committed_tail, tail);
+    }
+    atomic_store_explicit(&ring->header->tail, tail, memory_order_release);
+    if (ring->sync != FILE_RING_SYNC_NONE && error_code == 0) {
+        error_code = sync_header(ring);
+    }
+
+    record_error(ring, error_code);
+    ring->committed_tail = tail;
+    ring->committed_at = (ring->sync == FILE_RING_SYNC_INTERVAL) ? now_ns() : 0;
+}
+
+/***
+ * Check whether the sync policy wants the published items up to an index committed
+ * @param ring the ring
+ * @param tail the index past the last published item
+ * @return 1 if the items are due, 0 otherwise
+ */
+static int commit_due(file_ring_t *ring, unsigned long long tail) {
+    return ring->sync == FILE_RING_SYNC_NONE ||
+           (ring->sync == FILE_RING_SYNC_ITEMS && tail - ring->committed_tail >= ring->sync_period) ||
+           (ring->sync == FILE_RING_SYNC_INTERVAL && tail != ring->committed_tail &&
+            now_ns() - ring->committed_at >= ring->sync_period);
+}
+
+/***
+ * Reload the consumer's head into the producer's copy. With a sync policy the copy only goes as far as the head
+ * in the file, since recovery delivers the slots from there on again and a slot the consumer took must not be
+ * overwritten before the file says it is free, so a head that has moved on is written back first
+ * @param ring the ring
+ */
+static void refresh_head(file_ring_t *ring) {
+    if (ring->sync == FILE_RING_SYNC_NONE) {
+        ring->cached_head = atomic_load_explicit(&ring->header->head, memory_order_acquire);
+        return;
+    }
+
+    if (atomic_load_explicit(&ring->header->head, memory_order_relaxed) != ring->durable_head) {
+        record_error(ring, sync_header(ring));
+    }
+    ring->cached_head = ring->durable_head;
+}
+
+/***
+ * Initialize the header of a new file and publish its magic number once everything else is in the file, so a
+ * file whose creation was interrupted is initialized again when it is opened
+ * @param ring the ring
+ * @param capacity the maximum number of items the ring can hold
+ * @param slot_count the number of slots, a power of two
+ * @return 0 on success, an error number otherwise
+ */
+static int format(file_ring_t *ring, size_t capacity, size_t slot_count) {
+    file_ring_header_t *header = ring->header;
+    int error_code;
+
+    header->capacity = capacity;
+    header->mask = slot_count - 1;
+    atomic_store_explicit(&header->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&header->tail, 0, memory_order_relaxed);
+    error_code = sync_range(ring, header, (const char *) header + FILE_RING_HEADER_SIZE);
+    if (error_code != 0) {
+        return error_code;
+    }
+
+    atomic_store_explicit(&header->magic, FILE_RING_MAGIC, memory_order_release);
+    return sync_range(ring, header, (const char *) header + FILE_RING_HEADER_SIZE);
+}
+
+int file_ring_open(file_ring_t *ring, const char *path, size_t capacity, file_ring_sync_t sync,
+                   uint64_t sync_period) {
+    file_ring_header_t *header;
+    struct stat status;
+    unsigned long long head, tail;
+    size_t slot_count, size;
+    void *address;
+    int error_code = 0;
+
+    if (capacity == 0 || (sync != FILE_RING_SYNC_NONE && sync_period == 0)) {
+        return EINVAL;
+    }
+    slot_count = round_up_power_of_two(capacity);
+    size = FILE_RING_HEADER_SIZE + sizeof(long double) * slot_count;
+
+    ring->fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (ring->fd < 0) {
+        return errno;
+    }
+
+    // the lock is held until the file is closed, so only one producer and one consumer use the ring at a time
+    if (flock(ring->fd, LOCK_EX | LOCK_NB) != 0) {
+        error_code = (errno == EWOULDBLOCK) ? EBUSY : errno;
+    } else if (fstat(ring->fd, &status) != 0) {
+        error_code = errno;
+    } else if (status.st_size == 0) {
+        error_code = (ftruncate(ring->fd, (off_t) size) == 0) ? 0 : errno;
+    } else if ((size_t) status.st_size != size) {
+        error_code = EINVAL;
+    }
+    if (error_code != 0) {
+        close(ring->fd);
+        return error_code;
+    }
+
+    address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (address == MAP_FAILED) {
+        error_code = errno;
+        close(ring->fd);
+        return error_code;
+    }
+    ring->header = header = (file_ring_header_t *) address;
+    ring->slots = (long double *) ((char *) address + FILE_RING_HEADER_SIZE);
+    ring->size = size;
+    ring->page_size = (size_t) sysconf(_SC_PAGESIZE);
+
+    if (atomic_load_explicit(&header->magic, memory_order_acquire) == 0) {
+        error_code = format(ring, capacity, slot_count);
+    } else if (atomic_load_explicit(&header->magic, memory_order_relaxed) != FILE_RING_MAGIC ||
+               header->capacity != capacity || header->mask != slot_count - 1) {
+        error_code = EINVAL;
+    }
+    if (error_code != 0) {
+        munmap(address, size);
+        close(ring->fd);
+        return error_code;
+    }
+
+    // the consumer may have gone past the last commit before a crash, and after a crash of the machine the stored
+    // head may be older than the slots, resume from a range that is consistent with both
+    head = atomic_load_explicit(&header->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&header->tail, memory_order_relaxed);
+    if (head > tail) {
+        tail = head;
+    }
+    if (tail - head > capacity) {
+        head = tail - capacity;
+    }
+    atomic_store_explicit(&header->head, head, memory_order_relaxed);
+    atomic_store_explicit(&header->tail, tail, memory_order_relaxed);
+
+    ring->sync = sync;
+    ring->sync_period = sync_period;
+    ring->recovered = (size_t) (tail - head);
+    atomic_init(&ring->tail, tail);
+    ring->cached_head = head;
+    ring->durable_head = head;
+    ring->committed_tail = tail;
+    ring->committed_at = (sync == FILE_RING_SYNC_INTERVAL) ? now_ns() : 0;
+    ring->sync_error = 0;
+    ring->cached_tail = head;
+    wait_parker_init(&ring->not_full);
+    wait_parker_init(&ring->not_empty);
+    wait_statistics_init(&ring->producer_statistics);
+    wait_statistics_init(&ring->consumer_statistics);
+    return 0;
+}
+
+int file_ring_parse_sync(const char *policy, file_ring_sync_t *sync, uint64_t *sync_period) {
+    char *end;
+    unsigned long long period;
+
+    if (strcmp(policy, "none") == 0) {
+        *sync = FILE_RING_SYNC_NONE;
+        *sync_period = 0;
+        return 0;
+    }
+    if (strcmp(policy, "item") == 0) {
+        *sync = FILE_RING_SYNC_ITEMS;
+        *sync_period = 1;
+        return 0;
+    }
+
+    period = strtoull(policy, &end, 10);
+    if (end == policy || period == 0) {
+        return EINVAL;
+    }
+    if (*end == '\0') {
+        *sync = FILE_RING_SYNC_ITEMS;
+        *sync_period = period;
+    } else if (strcmp(end, "ms") == 0) {
+        *sync = FILE_RING_SYNC_INTERVAL;
+        *sync_period = period * 1000000ULL;
+    } else {
+        return EINVAL;
+    }
+    return 0;
+}
+
+int file_ring_sync(file_ring_t *ring) {
+    commit(ring, atomic_load_explicit(&ring->tail, memory_order_relaxed));
+    return ring->sync_error;
+}
+
+int file_ring_close(file_ring_t *ring) {
+    int error_code = file_ring_sync(ring);
+
+    // the header is written back even without a sync policy, so the final head of the consumer is in the file
+    if (error_code == 0 && ring->sync == FILE_RING_SYNC_NONE) {
+        error_code = sync_range(ring, ring->header, (const char *) ring->header + FILE_RING_HEADER_SIZE);
+    }
+    if (munmap(ring->header, ring->size) != 0 && error_code == 0) {
+        error_code = errno;
+    }
+    if (close(ring->fd) != 0 && error_code == 0) {
+        error_code = errno;
+    }
+    ring->header = NULL;
+    ring->slots = NULL;
+    return error_code;
+}
+
+int file_ring_try_push(file_ring_t *ring, long double item) {
+    file_ring_header_t *header = ring->header;
+
+    // only the producer writes tail, so a relaxed load of our own index is enough
+    unsigned long long tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    // only look at the consumer's line when our copy of head says the ring is full
+    if (tail - ring->cached_head == header->capacity) {
+        refresh_head(ring);
+        if (tail - ring->cached_head == header->capacity) {
+            // a producer waiting for room still commits on time, the consumer may be waiting for these items
+            if (ring->sync == FILE_RING_SYNC_INTERVAL && commit_due(ring, tail)) {
+                commit(ring, tail);
+            }
+            return 0;
+        }
+    }
+
+    ring->slots[tail & header->mask] = item;
+
+    // publish the item to the consumer, then commit it to the file when the sync policy says so
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    if (commit_due(ring, tail + 1)) {
+        commit(ring, tail + 1);
+    }
+    wait_parker_notify(&ring->not_empty, 1);
+    return 1;
+}
+
+int file_ring_try_pop(file_ring_t *ring, long double *item) {
+    file_ring_header_t *header = ring->header;
+
+    // only the consumer writes head, so a relaxed load of our own index is enough
+    unsigned long long head = atomic_load_explicit(&header->head, memory_order_relaxed);
+
+    // only look at the producer's line when our copy of tail says the ring is empty
+    if (head == ring->cached_tail) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->cached_tail) {
+            return 0;
+        }
+    }
+
+    *item = ring->slots[head & header->mask];
+
+    // hand the slot back to the producer, the head in the file becomes durable with the next commit
+    atomic_store_explicit(&header->head, head + 1, memory_order_release);
+    wait_parker_notify(&ring->not_full, 1);
+    return 1;
+}
+
+/***
+ * Wait condition that appends the item of an item context once there is room
+ * @param context the item context
+ * @return 1 if the item was appended, 0 otherwise
+ */
+static int push_condition(void *context) {
+    item_context_t *push = (item_context_t *) context;
+    return file_ring_try_push(push->ring, *push->item);
+}
+
+/***
+ * Wait condition that removes an item into an item context once there is one
+ * @param context the item context
+ * @return 1 if an item was removed, 0 otherwise
+ */
+static int pop_condition(void *context) {
+    item_context_t *pop = (item_context_t *) context;
+    return file_ring_try_pop(pop->ring, pop->item);
+}
+
+void file_ring_push(file_ring_t *ring, long double item) {
+    item_context_t context = {ring, &item};
+
+    if (!file_ring_try_push(ring, item)) {
+        wait_strategy_wait(&ring->not_full, &ring->producer_statistics, push_condition, &context);
+    }
+}
+
+long double file_ring_pop(file_ring_t *ring) {
+    long double item;
+    item_context_t context = {ring, &item};
+
+    if (!file_ring_try_pop(ring, &item)) {
+        wait_strategy_wait(&ring->not_empty, &ring->consumer_statistics, pop_condition, &context);
+    }
+    return item;
+}
+
+int file_ring_timed_push(file_ring_t *ring, long double item, const struct timespec *deadline) {
+    item_context_t context = {ring, &item};
+
+    if (file_ring_try_push(ring, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&ring->not_full, &ring->producer_statistics, push_condition, &context, deadline);
+}
+
+int file_ring_timed_pop(file_ring_t *ring, long double *item, const struct timespec *deadline) {
+    item_context_t context = {ring, item};
+
+    if (file_ring_try_pop(ring, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&ring->not_empty, &ring->consumer_statistics, pop_condition, &context, deadline);
+}
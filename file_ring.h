@@ -0,0 +1,183 @@
+/***
+ * Persistent single-producer/single-consumer ring buffer backed by a memory-mapped file
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * The same ring as spsc_ring_t, with its slots and indices in a file mapped with MAP_SHARED so that items which
+ * were published but not yet consumed survive the process. The file starts with a header page that holds the
+ * committed tail and the consumer's head; the slots follow on pages of their own.
+ *
+ * The producer publishes items to the consumer through a tail in process memory, exactly like spsc_ring_t, and
+ * commits them to the file according to the sync policy. A commit first writes back the pages of the slots
+ * published since the last commit, then stores the new tail in the header and writes back the header page, so the
+ * committed tail never covers a slot that is not on disk yet:
+ *
+ *  - FILE_RING_SYNC_NONE commits every item without writing anything back. Items survive a crash of the process,
+ *    since the pages stay in the page cache, but not a crash of the machine
+ *  - FILE_RING_SYNC_ITEMS commits once every period items, a period of 1 makes every push durable
+ *  - FILE_RING_SYNC_INTERVAL commits the first push at least period nanoseconds after the last commit, or the
+ *    first attempt of a producer waiting for room. Commits only happen in the producer, so a producer that goes
+ *    idle leaves its last items uncommitted until it calls file_ring_sync
+ *
+ * The consumer stores its head in the header after every item, it becomes durable with the next commit, so an
+ * item may be delivered again after a crash of the machine but is never lost once committed. With a sync policy
+ * the producer only reuses the slots before the durable head, the head that was in the header when it was last
+ * written back, since recovery delivers every slot from the head in the file on again. When only the consumer's
+ * newer head would make room, the producer writes back the header first.
+ *
+ * Opening an existing file recovers the ring: consumption resumes at the stored head and production at the
+ * committed tail, and the items in between are delivered first. The file is locked while it is open, a second
+ * open fails with EBUSY.
+ */
+
+#ifndef BOUNDED_BUFFER_FILE_RING_H
+#define BOUNDED_BUFFER_FILE_RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cache_line.h"
+#include "wait_strategy.h"
+
+#define FILE_RING_MAGIC 0x42424652u
+#define FILE_RING_HEADER_SIZE 4096
+
+/***
+ * When the producer commits published items to the file
+ */
+typedef enum {
+    FILE_RING_SYNC_NONE,
+    FILE_RING_SYNC_ITEMS,
+    FILE_RING_SYNC_INTERVAL
+} file_ring_sync_t;
+
+/***
+ * The header at the start of the file, the producer owns tail and the consumer owns head
+ */
+typedef struct file_ring_header {
+    CACHE_LINE_ALIGNED atomic_uint magic;
+    unsigned long long capacity;
+    unsigned long long mask;
+
+    CACHE_LINE_ALIGNED atomic_ullong tail;
+    CACHE_LINE_ALIGNED atomic_ullong head;
+} file_ring_header_t;
+
+/***
+ * A process's mapping of a ring, the producer owns tail, cached_head, durable_head and the commit state and the
+ * consumer owns cached_tail
+ */
+typedef struct file_ring {
+    CACHE_LINE_ALIGNED file_ring_header_t *header;
+    long double *slots;
+    size_t size;
+    size_t page_size;
+    int fd;
+    file_ring_sync_t sync;
+    uint64_t sync_period;
+    size_t recovered;
+
+    CACHE_LINE_ALIGNED atomic_ullong tail;
+    unsigned long long cached_head;
+    unsigned long long durable_head;
+    unsigned long long committed_tail;
+    uint64_t committed_at;
+    int sync_error;
+    wait_statistics_t producer_statistics;
+
+    CACHE_LINE_ALIGNED unsigned long long cached_tail;
+    wait_statistics_t consumer_statistics;
+
+    CACHE_LINE_ALIGNED wait_parker_t not_full;
+    CACHE_LINE_ALIGNED wait_parker_t not_empty;
+} file_ring_t;
+
+/***
+ * Open the ring stored in a file, creating the file if it does not exist and recovering the items it holds
+ * otherwise, the number of recovered items is stored in the recovered field of the ring
+ * @param ring the ring to initialize
+ * @param path the path of the file
+ * @param capacity the maximum number of items the ring can hold, storage is rounded up to a power of two, must
+ * match the capacity of an existing file
+ * @param sync when the producer commits items to the file
+ * @param sync_period the number of items of FILE_RING_SYNC_ITEMS or the nanoseconds of FILE_RING_SYNC_INTERVAL
+ * @return 0 on success, EBUSY if another ring has the file open, EINVAL if the file is not a ring of this
+ * capacity, another error number otherwise
+ */
+int file_ring_open(file_ring_t *ring, const char *path, size_t capacity, file_ring_sync_t sync,
+                   uint64_t sync_period);
+
+/***
+ * Parse a sync policy: none, item for a commit per item, a number of items or a number of milliseconds followed by
+ * ms
+ * @param policy the policy to parse
+ * @param sync location where the sync policy is stored
+ * @param sync_period location where the period of the policy is stored
+ * @return 0 on success, EINVAL if the policy is not valid
+ */
+int file_ring_parse_sync(const char *policy, file_ring_sync_t *sync, uint64_t *sync_period);
+
+/***
+ * Commit the items published so far and write back the header, must only be called from the producer
+ * @param ring the ring
+ * @return 0 on success, the error number of the first commit that failed since the ring was opened otherwise
+ */
+int file_ring_sync(file_ring_t *ring);
+
+/***
+ * Commit the items published so far and close the file, the items that were not consumed stay in it
+ * @param ring the ring to close
+ * @return 0 on success, an error number otherwise
+ */
+int file_ring_close(file_ring_t *ring);
+
+/***
+ * Append an item to the ring without waiting, must only be called from the producer
+ * @param ring the ring to append to
+ * @param item the item to append
+ * @return 1 if the item was appended, 0 if the ring was full
+ */
+int file_ring_try_push(file_ring_t *ring, long double item);
+
+/***
+ * Remove the oldest item from the ring without waiting, must only be called from the consumer
+ * @param ring the ring to remove from
+ * @param item location where the removed item is stored
+ * @return 1 if an item was removed, 0 if the ring was empty
+ */
+int file_ring_try_pop(file_ring_t *ring, long double *item);
+
+/***
+ * Append an item to the ring, waiting while the ring is full
+ * @param ring the ring to append to
+ * @param item the item to append
+ */
+void file_ring_push(file_ring_t *ring, long double item);
+
+/***
+ * Remove the oldest item from the ring, waiting while the ring is empty
+ * @param ring the ring to remove from
+ * @return the removed item
+ */
+long double file_ring_pop(file_ring_t *ring);
+
+/***
+ * Append an item, waiting while the ring is full but no longer than until a deadline
+ * @param ring the ring to append to
+ * @param item the item to append
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if the item was appended, ETIMEDOUT if the deadline passed first
+ */
+int file_ring_timed_push(file_ring_t *ring, long double item, const struct timespec *deadline);
+
+/***
+ * Remove an item, waiting while the ring is empty but no longer than until a deadline
+ * @param ring the ring to remove from
+ * @param item location where the removed item is stored
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if an item was removed, ETIMEDOUT if the deadline passed first
+ */
+int file_ring_timed_pop(file_ring_t *ring, long double *item, const struct timespec *deadline);
+
+#endif //BOUNDED_BUFFER_FILE_RING_H
@@ -0,0 +1,66 @@
+/***
+ * Lightweight counting semaphore built on a futex
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+
+#include "futex_semaphore.h"
+
+/***
+ * Wait condition that decrements the semaphore once its count is positive
+ * @param semaphore the semaphore to decrement
+ * @return 1 if the semaphore was decremented, 0 otherwise
+ */
+static int try_wait_condition(void *semaphore) {
+    return futex_semaphore_try_wait((futex_semaphore_t *) semaphore);
+}
+
+int futex_semaphore_init(futex_semaphore_t *semaphore, int value) {
+    if (value < 0) {
+        return EINVAL;
+    }
+
+    atomic_init(&semaphore->value, value);
+    wait_parker_init(&semaphore->parker);
+    wait_statistics_init(&semaphore->statistics);
+    return 0;
+}
+
+int futex_semaphore_destroy(futex_semaphore_t *semaphore) {
+    return (atomic_load(&semaphore->parker.waiters) == 0) ? 0 : EBUSY;
+}
+
+int futex_semaphore_try_wait(futex_semaphore_t *semaphore) {
+    int value = atomic_load_explicit(&semaphore->value, memory_order_relaxed);
+
+    // on failure the compare-and-swap reloads value, so retry until it is gone or we took one
+    while (value > 0) {
+        if (atomic_compare_exchange_weak_explicit(&semaphore->value, &value, value - 1,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void futex_semaphore_wait(futex_semaphore_t *semaphore) {
+    if (!futex_semaphore_try_wait(semaphore)) {
+        wait_strategy_wait(&semaphore->parker, &semaphore->statistics, try_wait_condition, semaphore);
+    }
+}
+
+int futex_semaphore_timed_wait(futex_semaphore_t *semaphore, const struct timespec *deadline) {
+    if (futex_semaphore_try_wait(semaphore)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&semaphore->parker, &semaphore->statistics, try_wait_condition, semaphore,
+                                    deadline);
+}
+
+void futex_semaphore_post(futex_semaphore_t *semaphore) {
+    atomic_fetch_add_explicit(&semaphore->value, 1, memory_order_release);
+    wait_parker_notify(&semaphore->parker, 1);
+}
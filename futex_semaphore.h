@@ -0,0 +1,70 @@
+/***
+ * Lightweight counting semaphore built on a futex
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * The count lives in a single atomic integer that wait and post update in user space. A waiter only enters the
+ * kernel when the count stays zero through the spinning and yielding phases of the wait strategy, and a poster
+ * only enters the kernel when the parker shows that some thread is actually parked, so an uncontended wait/post
+ * pair costs two atomic operations and no system call.
+ */
+
+#ifndef BOUNDED_BUFFER_FUTEX_SEMAPHORE_H
+#define BOUNDED_BUFFER_FUTEX_SEMAPHORE_H
+
+#include <stdatomic.h>
+
+#include "wait_strategy.h"
+
+/***
+ * The semaphore, waiters park on parker until value becomes positive
+ */
+typedef struct futex_semaphore {
+    atomic_int value;
+    wait_parker_t parker;
+    wait_statistics_t statistics;
+} futex_semaphore_t;
+
+/***
+ * Initialize the semaphore
+ * @param semaphore the semaphore to initialize
+ * @param value the initial count
+ * @return 0 on success, an error number otherwise
+ */
+int futex_semaphore_init(futex_semaphore_t *semaphore, int value);
+
+/***
+ * Destroy the semaphore
+ * @param semaphore the semaphore to destroy
+ * @return 0 on success, EBUSY if threads are still waiting on it
+ */
+int futex_semaphore_destroy(futex_semaphore_t *semaphore);
+
+/***
+ * Decrement the semaphore, waiting with the wait strategy while the count is zero
+ * @param semaphore the semaphore to decrement
+ */
+void futex_semaphore_wait(futex_semaphore_t *semaphore);
+
+/***
+ * Decrement the semaphore, waiting with the wait strategy while the count is zero but no longer than until a deadline
+ * @param semaphore the semaphore to decrement
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if the semaphore was decremented, ETIMEDOUT if the deadline passed first
+ */
+int futex_semaphore_timed_wait(futex_semaphore_t *semaphore, const struct timespec *deadline);
+
+/***
+ * Decrement the semaphore only if that can be done without waiting
+ * @param semaphore the semaphore to decrement
+ * @return 1 if the semaphore was decremented, 0 if the count was zero
+ */
+int futex_semaphore_try_wait(futex_semaphore_t *semaphore);
+
+/***
+ * Increment the semaphore, waking one parked thread if there is one
+ * @param semaphore the semaphore to increment
+ */
+void futex_semaphore_post(futex_semaphore_t *semaphore);
+
+#endif //BOUNDED_BUFFER_FUTEX_SEMAPHORE_H
@@ -0,0 +1,255 @@
+/***
+ * Per-thread log-linear latency histograms
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency_histogram.h"
+
+#define CALIBRATION_NANOSECONDS 10000000ULL
+
+/***
+ * The histogram the calling thread records into and the recorder it belongs to
+ */
+static _Thread_local latency_recorder_t *thread_recorder;
+static _Thread_local latency_histogram_t *thread_histogram;
+
+/***
+ * Find the bucket of a value
+ * @param value the value
+ * @return the index of the bucket
+ */
+static int bucket_of(uint64_t value) {
+    int exponent;
+
+    if (value < 2 * LATENCY_SUB_BUCKET_COUNT) {
+        return (int) value;
+    }
+
+    // the top LATENCY_SUB_BUCKET_BITS + 1 bits of the value pick the sub-bucket within its power of two
+    exponent = 63 - __builtin_clzll(value);
+    return (exponent - LATENCY_SUB_BUCKET_BITS) * LATENCY_SUB_BUCKET_COUNT +
+           (int) (value >> (exponent - LATENCY_SUB_BUCKET_BITS));
+}
+
+/***
+ * Find the value in the middle of a bucket
+ * @param bucket the index of the bucket
+ * @return the value
+ */
+static uint64_t value_of(int bucket) {
+    int shift;
+    uint64_t sub_bucket;
+
+    if (bucket < 2 * LATENCY_SUB_BUCKET_COUNT) {
+        return (uint64_t) bucket;
+    }
+
+    shift = bucket / LATENCY_SUB_BUCKET_COUNT - 1;
+    sub_bucket = (uint64_t) (bucket % LATENCY_SUB_BUCKET_COUNT + LATENCY_SUB_BUCKET_COUNT);
+    return (sub_bucket << shift) + ((1ULL << shift) >> 1);
+}
+
+/***
+ * Measure the length of a time stamp counter tick against CLOCK_MONOTONIC_RAW
+ * @param recorder the recorder whose clock is calibrated
+ */
+static void calibrate(latency_recorder_t *recorder) {
+    struct timespec start_time, end_time;
+    uint64_t start_ticks, end_ticks, elapsed;
+
+    recorder->nanoseconds_per_tick = 1.0;
+    if (recorder->clock != LATENCY_CLOCK_TSC) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &start_time);
+    start_ticks = latency_recorder_now(recorder);
+    do {
+        clock_gettime(CLOCK_MONOTONIC_RAW, &end_time);
+        elapsed = (uint64_t) (end_time.tv_sec - start_time.tv_sec) * 1000000000ULL + end_time.tv_nsec -
+                  start_time.tv_nsec;
+    } while (elapsed < CALIBRATION_NANOSECONDS);
+    end_ticks = latency_recorder_now(recorder);
+
+    recorder->nanoseconds_per_tick = (double) elapsed / (double) (end_ticks - start_ticks);
+}
+
+int latency_recorder_init(latency_recorder_t *recorder, latency_clock_t clock) {
+    int thread_index;
+
+#if !defined(__x86_64__) && !defined(__i386__)
+    if (clock == LATENCY_CLOCK_TSC) {
+        return ENOTSUP;
+    }
+#endif
+
+    recorder->histograms = (latency_histogram_t *) aligned_alloc(CACHE_LINE_SIZE,
+                                                                 sizeof(latency_histogram_t) * LATENCY_MAX_THREADS);
+    if (recorder->histograms == NULL) {
+        return ENOMEM;
+    }
+
+    for (thread_index = 0; thread_index < LATENCY_MAX_THREADS; thread_index++) {
+        latency_histogram_reset(&recorder->histograms[thread_index]);
+        atomic_init(&recorder->ready[thread_index], 0);
+    }
+
+    recorder->clock = clock;
+    atomic_init(&recorder->thread_count, 0);
+    calibrate(recorder);
+    return 0;
+}
+
+int latency_recorder_destroy(latency_recorder_t *recorder) {
+    free(recorder->histograms);
+    recorder->histograms = NULL;
+    return 0;
+}
+
+/***
+ * Find the histogram of the calling thread, registering a new one if the thread has none yet
+ * @param recorder the recorder
+ * @return the histogram, NULL if every histogram is taken
+ */
+static latency_histogram_t *register_thread(latency_recorder_t *recorder) {
+    int thread_index, thread_count = atomic_load(&recorder->thread_count);
+    pthread_t self = pthread_self();
+
+    // a thread that switched between recorders already owns a histogram here, the count briefly goes past the
+    // last histogram while a thread that found none left backs out
+    if (thread_count > LATENCY_MAX_THREADS) {
+        thread_count = LATENCY_MAX_THREADS;
+    }
+    for (thread_index = 0; thread_index < thread_count; thread_index++) {
+        // a histogram that was claimed but whose owner is not written yet belongs to another registering thread
+        if (atomic_load_explicit(&recorder->ready[thread_index], memory_order_acquire) &&
+            pthread_equal(recorder->owners[thread_index], self)) {
+            return &recorder->histograms[thread_index];
+        }
+    }
+
+    thread_index = atomic_fetch_add(&recorder->thread_count, 1);
+    if (thread_index >= LATENCY_MAX_THREADS) {
+        atomic_fetch_sub(&recorder->thread_count, 1);
+        return NULL;
+    }
+
+    // release pairs with the acquire of the scan above, so a thread that sees the flag sees the owner
+    recorder->owners[thread_index] = self;
+    atomic_store_explicit(&recorder->ready[thread_index], 1, memory_order_release);
+    return &recorder->histograms[thread_index];
+}
+
+void latency_recorder_record(latency_recorder_t *recorder, uint64_t ticks) {
+    latency_histogram_t *histogram;
+    int bucket;
+
+    if (thread_recorder != recorder) {
+        thread_histogram = register_thread(recorder);
+        thread_recorder = recorder;
+    }
+    histogram = thread_histogram;
+    if (histogram == NULL) {
+        return;
+    }
+
+    // this thread is the only writer, so plain loads and stores are enough and readers never see a torn value
+    bucket = bucket_of(ticks);
+    atomic_store_explicit(&histogram->counts[bucket],
+                          atomic_load_explicit(&histogram->counts[bucket], memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_store_explicit(&histogram->count, atomic_load_explicit(&histogram->count, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    if (ticks > atomic_load_explicit(&histogram->maximum, memory_order_relaxed)) {
+        atomic_store_explicit(&histogram->maximum, ticks, memory_order_relaxed);
+    }
+}
+
+void latency_histogram_reset(latency_histogram_t *histogram) {
+    int bucket;
+
+    atomic_init(&histogram->count, 0);
+    atomic_init(&histogram->maximum, 0);
+    for (bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+        atomic_init(&histogram->counts[bucket], 0);
+    }
+}
+
+void latency_recorder_merge(latency_recorder_t *recorder, latency_histogram_t *merged) {
+    int thread_index, bucket, thread_count = atomic_load(&recorder->thread_count);
+    unsigned long long count, maximum;
+
+    if (thread_count > LATENCY_MAX_THREADS) {
+        thread_count = LATENCY_MAX_THREADS;
+    }
+
+    for (thread_index = 0; thread_index < thread_count; thread_index++) {
+        latency_histogram_t *histogram = &recorder->histograms[thread_index];
+
+        // the total is the sum of the buckets read here, so a concurrent writer cannot make it inconsistent
+        for (bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+            count = atomic_load_explicit(&histogram->counts[bucket], memory_order_relaxed);
+            if (count > 0) {
+                atomic_fetch_add_explicit(&merged->counts[bucket], count, memory_order_relaxed);
+                atomic_fetch_add_explicit(&merged->count, count, memory_order_relaxed);
+            }
+        }
+
+        maximum = atomic_load_explicit(&histogram->maximum, memory_order_relaxed);
+        if (maximum > atomic_load_explicit(&merged->maximum, memory_order_relaxed)) {
+            atomic_store_explicit(&merged->maximum, maximum, memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t latency_histogram_percentile(latency_histogram_t *histogram, double percentile) {
+    unsigned long long total = atomic_load(&histogram->count), seen = 0, rank;
+    uint64_t maximum = atomic_load(&histogram->maximum), value;
+    int bucket;
+
+    if (total == 0) {
+        return 0;
+    }
+
+    rank = (unsigned long long) (percentile / 100.0 * (double) total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    for (bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++) {
+        seen += atomic_load(&histogram->counts[bucket]);
+        if (seen >= rank) {
+            value = value_of(bucket);
+            return (value < maximum) ? value : maximum;
+        }
+    }
+    return maximum;
+}
+
+void latency_recorder_print(const char *name, latency_recorder_t *recorder) {
+    latency_histogram_t *merged = (latency_histogram_t *) aligned_alloc(CACHE_LINE_SIZE, sizeof(latency_histogram_t));
+    double scale = recorder->nanoseconds_per_tick;
+
+    if (merged == NULL) {
+        printf("Could not allocate memory for %s latency histogram\n", name);
+        return;
+    }
+
+    latency_histogram_reset(merged);
+    latency_recorder_merge(recorder, merged);
+
+    printf("%s latency over %llu items in ns: p50 %.0f, p90 %.0f, p99 %.0f, p99.9 %.0f, max %.0f\n", name,
+           atomic_load(&merged->count),
+           scale * (double) latency_histogram_percentile(merged, 50.0),
+           scale * (double) latency_histogram_percentile(merged, 90.0),
+           scale * (double) latency_histogram_percentile(merged, 99.0),
+           scale * (double) latency_histogram_percentile(merged, 99.9),
+           scale * (double) atomic_load(&merged->maximum));
+    free(merged);
+}
@@ -0,0 +1,143 @@
+/***
+ * Per-thread log-linear latency histograms
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Values below 64 are counted exactly, larger values are counted in 32 linear sub-buckets per power of two, so
+ * every bucket is within about 3% of the values it holds (the bucket layout of an HDR histogram with two
+ * significant binary digits of five bits). Each thread records into a histogram of its own with plain relaxed
+ * stores and any thread can merge all histograms of a recorder at any time without stopping the writers.
+ *
+ * Latencies are measured in ticks of the clock chosen for the recorder, either CLOCK_MONOTONIC_RAW in nanoseconds
+ * or the time stamp counter, which is calibrated against CLOCK_MONOTONIC_RAW when the recorder is initialized and
+ * assumed to be invariant and synchronized across cores.
+ */
+
+#ifndef BOUNDED_BUFFER_LATENCY_HISTOGRAM_H
+#define BOUNDED_BUFFER_LATENCY_HISTOGRAM_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "cache_line.h"
+
+#define LATENCY_SUB_BUCKET_BITS 5
+#define LATENCY_SUB_BUCKET_COUNT (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKET_COUNT ((64 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKET_COUNT)
+#define LATENCY_MAX_THREADS 64
+
+/***
+ * The clocks latencies can be measured with
+ */
+typedef enum {
+    LATENCY_CLOCK_MONOTONIC_RAW,
+    LATENCY_CLOCK_TSC
+} latency_clock_t;
+
+/***
+ * A histogram, written by one thread and read by any
+ */
+typedef struct latency_histogram {
+    CACHE_LINE_ALIGNED atomic_ullong count;
+    atomic_ullong maximum;
+    atomic_ullong counts[LATENCY_BUCKET_COUNT];
+} latency_histogram_t;
+
+/***
+ * A set of per-thread histograms, owners records which thread each histogram belongs to and ready is set once the
+ * owner of a histogram is written, since thread_count counts a histogram as soon as a thread claims it
+ */
+typedef struct latency_recorder {
+    latency_clock_t clock;
+    double nanoseconds_per_tick;
+    atomic_int thread_count;
+    pthread_t owners[LATENCY_MAX_THREADS];
+    atomic_int ready[LATENCY_MAX_THREADS];
+    latency_histogram_t *histograms;
+} latency_recorder_t;
+
+/***
+ * Initialize a recorder and calibrate its clock
+ * @param recorder the recorder to initialize
+ * @param clock the clock to measure latencies with
+ * @return 0 on success, an error number otherwise
+ */
+int latency_recorder_init(latency_recorder_t *recorder, latency_clock_t clock);
+
+/***
+ * Release the histograms of a recorder
+ * @param recorder the recorder to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int latency_recorder_destroy(latency_recorder_t *recorder);
+
+/***
+ * Read the clock of a recorder
+ * @param recorder the recorder
+ * @return the current time in ticks of the recorder's clock
+ */
+static inline uint64_t latency_recorder_now(const latency_recorder_t *recorder) {
+    struct timespec time;
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (recorder->clock == LATENCY_CLOCK_TSC) {
+        return __rdtsc();
+    }
+#endif
+    clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+    return (uint64_t) time.tv_sec * 1000000000ULL + (uint64_t) time.tv_nsec;
+}
+
+/***
+ * Get the ticks elapsed since a stamp taken with the clock of a recorder, possibly on another core
+ * @param recorder the recorder
+ * @param stamp the earlier reading of the clock
+ * @return the elapsed ticks, 0 if the clocks of the two cores disagree by more than the latency
+ */
+static inline uint64_t latency_recorder_elapsed(const latency_recorder_t *recorder, uint64_t stamp) {
+    uint64_t now = latency_recorder_now(recorder);
+    return (now > stamp) ? now - stamp : 0;
+}
+
+/***
+ * Record a latency in the calling thread's histogram, registering one on the first call from a thread
+ * @param recorder the recorder
+ * @param ticks the latency in ticks of the recorder's clock
+ */
+void latency_recorder_record(latency_recorder_t *recorder, uint64_t ticks);
+
+/***
+ * Merge the histograms of every thread, may be called while other threads record
+ * @param recorder the recorder
+ * @param merged the histogram the counts are added to
+ */
+void latency_recorder_merge(latency_recorder_t *recorder, latency_histogram_t *merged);
+
+/***
+ * Clear a histogram
+ * @param histogram the histogram to clear
+ */
+void latency_histogram_reset(latency_histogram_t *histogram);
+
+/***
+ * Get a percentile of a histogram
+ * @param histogram the histogram
+ * @param percentile the percentile, between 0 and 100
+ * @return a value equivalent to the percentile within the precision of its bucket, in ticks
+ */
+uint64_t latency_histogram_percentile(latency_histogram_t *histogram, double percentile);
+
+/***
+ * Print the count, the common percentiles and the maximum of every thread's histograms merged
+ * @param name the name of the latency
+ * @param recorder the recorder
+ */
+void latency_recorder_print(const char *name, latency_recorder_t *recorder);
+
+#endif //BOUNDED_BUFFER_LATENCY_HISTOGRAM_H
@@ -6,116 +6,1861 @@
  * @see Figure 6.9, 6.10 for psuedo code (Operating System Concepts (9th Edition) - Silberschatz, Galvin, and Gagne)
  */
 
+#define _GNU_SOURCE
+
+#include <stdarg.h>
 #include <stdio.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <semaphore.h>
+#include <signal.h>
 #include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "async_logger.h"
+#include "bignum.h"
+#include "buffer_memory.h"
+#include "core_latency.h"
+#include "cache_line.h"
+#include "event_notifier.h"
+#include "factorial.h"
+#include "file_ring.h"
+#include "futex_semaphore.h"
+#include "latency_histogram.h"
+#include "mpmc_queue.h"
+#include "priority_queue.h"
+#include "ring_math.h"
+#include "sharded_queue.h"
+#include "shm_ring.h"
+#include "spsc_ring.h"
+#include "thread_placement.h"
+#include "wait_strategy.h"
+#include "work_pool.h"
+
+#define MAX_BUFFER_SIZE 100
+
+/***
+ * The nanoseconds the consumer of the shm mode waits for an item before it checks whether the producer process is
+ * still running
+ */
+#define PRODUCER_CHECK_INTERVAL 100000000ULL
+
+/***
+ * The available synchronization modes for the buffer
+ */
+typedef enum {
+    MODE_SEMAPHORE,
+    MODE_FUTEX,
+    MODE_SPSC,
+    MODE_MPMC,
+    MODE_SHM,
+    MODE_FILE,
+    MODE_SHARDED,
+    MODE_PRIORITY
+} buffer_mode_t;
+
+/***
+ * The synchronization mode selected at startup
+ */
+buffer_mode_t mode = MODE_SEMAPHORE;
+
+/***
+ * The number of producer and consumer threads, only the MPMC, sharded and priority modes support more than one of
+ * each
+ */
+int producer_count = 1, consumer_count = 1;
+
+/***
+ * The number of items each producer produces, the buffer is reused circularly so this may exceed its capacity
+ */
+unsigned long long item_count = MAX_BUFFER_SIZE;
+
+/***
+ * The number of items moved per synchronization in SPSC mode
+ */
+size_t batch_size = 1;
+
+/***
+ * The capacity of the local deque of every consumer in semaphore mode, 0 for a single consumer without a pool
+ */
+size_t deque_capacity = 0;
+
+/***
+ * The nanoseconds after which a semaphore wait in semaphore or futex mode gives up, 0 to wait for as long as it
+ * takes, and the number of waits of the producer and the consumer of semaphore mode that gave up
+ */
+uint64_t wait_timeout = 0;
+atomic_ullong producer_timeouts, consumer_timeouts;
+
+/***
+ * Set to suppress the per item output, useful for long running soak tests
+ */
+int quiet = 0;
+
+/***
+ * bounded buffer to store the elements, the storage is rounded up to a power of two so that the slot for an
+ * item is found by masking its index with buffer_mask
+ */
+CACHE_LINE_ALIGNED long double *buffer;
+size_t buffer_mask;
+
+/***
+ * Set to hand the output of the worker threads to the asynchronous logger instead of printf
+ */
+int async_logging = 0;
+async_logger_t logger;
+
+/***
+ * Set to record the time every item spends in the buffer, and the per thread histograms it is recorded into
+ */
+int latency_enabled = 0;
+latency_clock_t latency_clock = LATENCY_CLOCK_MONOTONIC_RAW;
+latency_recorder_t latency;
+
+/***
+ * The time every slot of buffer was published at, only allocated when latency recording is enabled
+ */
+uint64_t *buffer_stamps;
+
+/***
+ * The required counting semaphores, each on its own cache line since the producer waits on one while the
+ * consumer waits on the other
+ */
+CACHE_LINE_ALIGNED sem_t empty_semaphore;
+CACHE_LINE_ALIGNED sem_t full_semaphore;
+
+/***
+ * The futex based counting semaphores used in place of the POSIX ones in futex mode
+ */
+CACHE_LINE_ALIGNED futex_semaphore_t empty_futex_semaphore;
+CACHE_LINE_ALIGNED futex_semaphore_t full_futex_semaphore;
+
+/***
+ * The required mutex lock, kept off the lines of the semaphores and the buffer pointer
+ */
+CACHE_LINE_ALIGNED pthread_mutex_t lock;
+
+/***
+ * The lock-free ring used in place of buffer, the semaphores and the lock in SPSC mode
+ */
+spsc_ring_t ring;
+
+/***
+ * Set to let the consumer of SPSC mode wait for the ring in epoll, and the notifier whose eventfd it waits for
+ */
+int event_driven = 0;
+event_notifier_t ring_events;
+
+/***
+ * The lock-free queue shared by all producers and consumers in MPMC mode
+ */
+mpmc_queue_t queue;
+
+/***
+ * The work-stealing pool of the consumers in semaphore mode with -k, the index of the next item the pool takes
+ * from buffer, guarded by lock, and the number of items the workers have consumed
+ */
+work_pool_t work_pool;
+unsigned long long pool_item_index = 0;
+atomic_ullong items_consumed;
+
+/***
+ * The queue with a lane per producer used in sharded mode and how its consumers move between the lanes
+ */
+sharded_queue_t sharded_queue;
+sharded_queue_policy_t sharded_policy = SHARDED_QUEUE_ROUND_ROBIN;
+
+/***
+ * The queue with a lane per priority level used in priority mode, how its consumers pick a lane and the weight of
+ * every lane, most urgent first, producer i feeds lane i modulo the number of lanes
+ */
+priority_queue_t priority_queue;
+priority_queue_policy_t priority_policy = PRIORITY_QUEUE_STRICT;
+unsigned int priority_weights[MAX_PRIORITY_LANES] = {4, 1};
+int priority_lane_count = 2;
+
+/***
+ * The lock-free ring shared with the producer process in shared memory mode, its name and the producer's process
+ */
+shm_ring_t shm_ring;
+char shm_name[64];
+pid_t producer_process;
+
+/***
+ * Set once the consumer of the shm mode found the producer process exited, together with its exit status
+ */
+int producer_reaped = 0;
+int producer_status;
+
+/***
+ * The persistent ring used in file mode, the path of its file and when the producer commits items to it
+ */
+file_ring_t file_ring;
+const char *file_path = "bounded_buffer.ring";
+file_ring_sync_t file_sync = FILE_RING_SYNC_NONE;
+uint64_t file_sync_period = 0;
+
+/***
+ * The number of items claimed by consumers in MPMC, sharded and priority mode, a consumer only pops after claiming an
+ * item so that every consumer knows when the producers are done
+ */
+atomic_ullong items_claimed;
+
+/***
+ * Set to produce exact factorials of the item index modulo exact_range, which are passed through the buffer by
+ * their handle in bignum_pool
+ */
+unsigned int exact_range = 0;
+bignum_pool_t bignum_pool;
+
+/***
+ * The placement of the worker threads as given on the command line, the CPUs of the producers followed by those
+ * of the consumers, NULL to leave them unpinned, and the scheduling policy of every worker thread
+ */
+const char *placement = NULL;
+int *thread_cpus = NULL;
+thread_schedule_t thread_schedule = {-1, 0};
+
+/***
+ * How the buffer storage is mapped, configured once the threads are placed so that it can follow the consumer
+ */
+buffer_memory_policy_t memory_policy = {BUFFER_PAGES_DEFAULT, 0, -1};
+
+/***
+ * Print a message from a worker thread, through the asynchronous logger when it is enabled
+ * @param format the printf format
+ */
+void log_message(const char *format, ...) {
+    va_list arguments;
+
+    va_start(arguments, format);
+    if (async_logging) {
+        async_logger_vlog(&logger, format, arguments);
+    } else {
+        vprintf(format, arguments);
+    }
+    va_end(arguments);
+}
+
+/***
+ * Decrement a POSIX semaphore, with -T giving up at every deadline to count the stall before waiting again, which is
+ * where a latency-sensitive caller would shed or reroute the item instead
+ * @param semaphore the semaphore to decrement
+ * @param timeouts the counter of the waits that gave up
+ */
+void buffer_wait(sem_t *semaphore, atomic_ullong *timeouts) {
+    struct timespec deadline;
+
+    if (wait_timeout == 0) {
+        sem_wait(semaphore);
+        return;
+    }
+
+    // sem_timedwait measures its deadline on the wall clock, which may jump, sem_clockwait takes the clock
+    wait_deadline_after(&deadline, wait_timeout);
+    while (sem_clockwait(semaphore, CLOCK_MONOTONIC, &deadline) != 0) {
+        if (errno == ETIMEDOUT) {
+            atomic_fetch_add(timeouts, 1);
+            wait_deadline_after(&deadline, wait_timeout);
+        }
+    }
+}
+
+/***
+ * Decrement a futex semaphore, with -T giving up at every deadline to count the stall in the statistics of the
+ * semaphore before waiting again
+ * @param semaphore the semaphore to decrement
+ */
+void futex_buffer_wait(futex_semaphore_t *semaphore) {
+    struct timespec deadline;
+
+    if (wait_timeout == 0) {
+        futex_semaphore_wait(semaphore);
+        return;
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (futex_semaphore_timed_wait(semaphore, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+}
+
+/**
+ * Method to simulate a long running process synomous to "prodcing" an item
+ * @param item_index the index of the item
+ * @return a really long number, or the handle of an exact one in bignum_pool
+ */
+long double produce_item(unsigned long long item_index) {
+    size_t handle;
+    int error_code;
+
+    if (exact_range == 0) {
+        // the input wraps so the items stay finite
+        return factorial((unsigned int) (item_index % MAX_BUFFER_SIZE));
+    }
+
+    handle = bignum_pool_acquire(&bignum_pool);
+    error_code = bignum_factorial(bignum_pool_get(&bignum_pool, handle), (unsigned int) (item_index % exact_range));
+    if (error_code != 0) {
+        log_message("Could not compute exact factorial, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+    return (long double) handle;
+}
+
+/***
+ * Method to "produce" a batch of consecutive items in one pass
+ * @param items the array the items are stored in
+ * @param item_index the index of the first item
+ * @param count the number of items
+ */
+void produce_items(long double *items, unsigned long long item_index, size_t count) {
+    size_t batch_index;
+
+    if (exact_range == 0) {
+        factorial_batch(items, (unsigned int) (item_index % MAX_BUFFER_SIZE), count, MAX_BUFFER_SIZE);
+        return;
+    }
+    for (batch_index = 0; batch_index < count; batch_index++) {
+        items[batch_index] = produce_item(item_index + batch_index);
+    }
+}
+
+/***
+ * Method to "consume" an item, returns the number behind an exact item to the pool
+ * @param item the item
+ */
+void consume_item(long double item) {
+    if (exact_range != 0) {
+        bignum_pool_release(&bignum_pool, (size_t) item);
+    }
+}
+
+/***
+ * The producer function
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *producer(void *dummy) {
+    unsigned long long item_index = 0;
+    log_message("Producer thread started\n");
+
+    do {
+        // produce the item to be stored in the buffer
+        long double item = produce_item(item_index);
+
+        // decrement the empty semaphore
+        buffer_wait(&empty_semaphore, &producer_timeouts);
+
+        // acquire the lock
+        pthread_mutex_lock(&lock);
+
+        buffer[item_index & buffer_mask] = item;
+        if (latency_enabled) {
+            buffer_stamps[item_index & buffer_mask] = latency_recorder_now(&latency);
+        }
+        if (!quiet) {
+            log_message("Produced %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+
+        // release the lock
+        pthread_mutex_unlock(&lock);
+
+        // increment the full semaphore
+        sem_post(&full_semaphore);
+
+        // the idle workers of the pool wait on the pool rather than on the full semaphore
+        if (deque_capacity > 0) {
+            work_pool_notify(&work_pool);
+        }
+    } while (item_index < item_count);
+
+    return NULL;
+}
+
+/***
+ * The consumer function
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *consumer(void *dummy) {
+    unsigned long long item_index = 0;
+    long double item;
+    log_message("Consumer thread started\n");
+
+    do {
+        // decrement the full semaphore
+        buffer_wait(&full_semaphore, &consumer_timeouts);
+
+        // acquire the lock
+        pthread_mutex_lock(&lock);
+
+        item = buffer[item_index & buffer_mask];
+        if (latency_enabled) {
+            latency_recorder_record(&latency,
+                                    latency_recorder_elapsed(&latency, buffer_stamps[item_index & buffer_mask]));
+        }
+        if (!quiet) {
+            log_message("Consumed %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+
+        // release the lock
+        pthread_mutex_unlock(&lock);
+
+        // increment the empty semaphore
+        sem_post(&empty_semaphore);
+
+        consume_item(item);
+    } while (item_index < item_count);
+
+    return NULL;
+}
+
+/***
+ * Context of a worker of the pool that waits for work, the batch holds the items it took
+ */
+typedef struct pool_context {
+    int worker;
+    long double *batch;
+    size_t count;
+} pool_context_t;
+
+/***
+ * Move the items waiting in buffer into a batch with one acquisition of the lock, as many as the batch can hold
+ * @param batch the array the items are stored in
+ * @param max_count the number of items the batch can hold
+ * @return the number of items moved, 0 if buffer was empty
+ */
+size_t pool_take_batch(long double *batch, size_t max_count) {
+    size_t count = 0, posted;
+
+    if (sem_trywait(&full_semaphore) != 0) {
+        return 0;
+    }
+
+    // acquire the lock
+    pthread_mutex_lock(&lock);
+
+    // every successful wait on the full semaphore stands for one item the lock lets us take
+    do {
+        batch[count++] = buffer[pool_item_index & buffer_mask];
+        if (latency_enabled) {
+            latency_recorder_record(&latency,
+                                    latency_recorder_elapsed(&latency, buffer_stamps[pool_item_index & buffer_mask]));
+        }
+        if (!quiet) {
+            log_message("Consumed %llu\n", pool_item_index);
+        }
+        pool_item_index = (pool_item_index + 1);
+    } while (count < max_count && sem_trywait(&full_semaphore) == 0);
+
+    // release the lock
+    pthread_mutex_unlock(&lock);
+
+    // increment the empty semaphore once for every slot handed back
+    for (posted = 0; posted < count; posted++) {
+        sem_post(&empty_semaphore);
+    }
+    return count;
+}
+
+/***
+ * Wait condition of an idle worker: the pool is done, it stole from another worker, or it took a batch from buffer
+ * @param context the pool context, count is 0 when the pool is done
+ * @return 1 once the worker has work or the pool is done, 0 otherwise
+ */
+int pool_condition(void *context) {
+    pool_context_t *pool = (pool_context_t *) context;
+
+    pool->count = 0;
+    if (atomic_load(&items_consumed) >= item_count) {
+        return 1;
+    }
+    if (work_pool_take(&work_pool, pool->worker, &pool->batch[0])) {
+        pool->count = 1;
+        return 1;
+    }
+
+    // the first item is consumed right away, so the batch holds one item more than the deque has room for
+    pool->count = pool_take_batch(pool->batch, 1 + work_pool_room(&work_pool, pool->worker));
+    return pool->count > 0;
+}
+
+/***
+ * The consumer function of the work-stealing pool, every worker moves batches from buffer into its local deque and
+ * steals half of the busiest worker's deque when its own runs dry
+ * @param id the index of the worker
+ * @return NULL
+ */
+void *pool_consumer(void *id) {
+    pool_context_t context = {(int) (intptr_t) id, NULL, 0};
+    struct timespec deadline;
+    long double item;
+    log_message("Consumer thread %d started\n", context.worker);
+
+    context.batch = (long double *) malloc(sizeof(long double) * (deque_capacity + 1));
+    if (context.batch == NULL) {
+        log_message("Could not allocate memory for consumer batch\n");
+        exit(EXIT_FAILURE);
+    }
+
+    while (atomic_load(&items_consumed) < item_count) {
+        if (!work_pool_take(&work_pool, context.worker, &item)) {
+            // wait until there is something to steal or take from buffer, then share the rest of a batch, with -T
+            // giving up at every deadline to count the stall in the statistics of the pool before waiting again
+            if (wait_timeout == 0) {
+                wait_strategy_wait(&work_pool.work_available, &work_pool.statistics, pool_condition, &context);
+            } else {
+                wait_deadline_after(&deadline, wait_timeout);
+                while (wait_strategy_wait_until(&work_pool.work_available, &work_pool.statistics, pool_condition,
+                                                &context, &deadline) == ETIMEDOUT) {
+                    wait_deadline_after(&deadline, wait_timeout);
+                }
+            }
+            if (context.count == 0) {
+                continue;
+            }
+            item = context.batch[0];
+            if (context.count > 1) {
+                work_pool_push(&work_pool, context.worker, context.batch + 1, context.count - 1);
+            }
+        }
+
+        consume_item(item);
+
+        // the worker that consumes the last item wakes every idle worker so they can return
+        if (atomic_fetch_add(&items_consumed, 1) + 1 == item_count) {
+            work_pool_notify_all(&work_pool);
+        }
+    }
+
+    free(context.batch);
+    return NULL;
+}
+
+/***
+ * The producer function for the futex semaphore mode
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *futex_producer(void *dummy) {
+    unsigned long long item_index = 0;
+    log_message("Producer thread started\n");
+
+    do {
+        // produce the item to be stored in the buffer
+        long double item = produce_item(item_index);
+
+        // decrement the empty semaphore
+        futex_buffer_wait(&empty_futex_semaphore);
+
+        // acquire the lock
+        pthread_mutex_lock(&lock);
+
+        buffer[item_index & buffer_mask] = item;
+        if (latency_enabled) {
+            buffer_stamps[item_index & buffer_mask] = latency_recorder_now(&latency);
+        }
+        if (!quiet) {
+            log_message("Produced %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+
+        // release the lock
+        pthread_mutex_unlock(&lock);
+
+        // increment the full semaphore
+        futex_semaphore_post(&full_futex_semaphore);
+    } while (item_index < item_count);
+
+    return NULL;
+}
+
+/***
+ * The consumer function for the futex semaphore mode
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *futex_consumer(void *dummy) {
+    unsigned long long item_index = 0;
+    long double item;
+    log_message("Consumer thread started\n");
+
+    do {
+        // decrement the full semaphore
+        futex_buffer_wait(&full_futex_semaphore);
+
+        // acquire the lock
+        pthread_mutex_lock(&lock);
+
+        item = buffer[item_index & buffer_mask];
+        if (latency_enabled) {
+            latency_recorder_record(&latency,
+                                    latency_recorder_elapsed(&latency, buffer_stamps[item_index & buffer_mask]));
+        }
+        if (!quiet) {
+            log_message("Consumed %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+
+        // release the lock
+        pthread_mutex_unlock(&lock);
+
+        // increment the empty semaphore
+        futex_semaphore_post(&empty_futex_semaphore);
+
+        consume_item(item);
+    } while (item_index < item_count);
+
+    return NULL;
+}
+
+/***
+ * Append an item to the ring of the spsc mode, with -T giving up at every deadline to count the stall in the statistics
+ * of the ring before waiting again
+ * @param item the item to append
+ */
+void spsc_buffer_push(long double item) {
+    struct timespec deadline;
+
+    if (wait_timeout == 0) {
+        spsc_ring_push(&ring, item);
+        return;
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (spsc_ring_timed_push(&ring, item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+}
+
+/***
+ * Remove an item from the ring of the spsc mode, with -T giving up at every deadline to count the stall in the
+ * statistics of the ring before waiting again
+ * @return the removed item
+ */
+long double spsc_buffer_pop(void) {
+    struct timespec deadline;
+    long double item;
+
+    if (wait_timeout == 0) {
+        return spsc_ring_pop(&ring);
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (spsc_ring_timed_pop(&ring, &item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+    return item;
+}
+
+/***
+ * The producer function for the lock-free SPSC mode
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *spsc_producer(void *dummy) {
+    unsigned long long item_index = 0;
+    log_message("Producer thread started\n");
+
+    do {
+        // produce the item to be stored in the buffer
+        long double item = produce_item(item_index);
+
+        // wait for a free slot and publish the item
+        spsc_buffer_push(item);
+
+        if (!quiet) {
+            log_message("Produced %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count);
+
+    return NULL;
+}
+
+/***
+ * The consumer function for the lock-free SPSC mode
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *spsc_consumer(void *dummy) {
+    unsigned long long item_index = 0;
+    log_message("Consumer thread started\n");
+
+    do {
+        // wait for an item and hand its slot back to the producer
+        consume_item(spsc_buffer_pop());
+
+        if (!quiet) {
+            log_message("Consumed %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count);
+
+    return NULL;
+}
+
+/***
+ * The consumer function for the lock-free SPSC mode when it waits for the ring in epoll, next to a periodic timer
+ * that stands in for the other descriptors an event loop serves
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *event_consumer(void *dummy) {
+    unsigned long long item_index = 0, wakeups = 0, ticks = 0, expirations;
+    struct itimerspec interval = {{0, 100000000}, {0, 100000000}};
+    struct epoll_event event;
+    long double item;
+    int poll_fd, timer_fd, armed = 1;
+
+    poll_fd = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (poll_fd < 0 || timer_fd < 0 || timerfd_settime(timer_fd, 0, &interval, NULL) != 0) {
+        log_message("Could not create event loop, error code = %d\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    event.events = EPOLLIN;
+    event.data.fd = ring_events.fd;
+    if (epoll_ctl(poll_fd, EPOLL_CTL_ADD, ring_events.fd, &event) != 0) {
+        log_message("Could not watch ring, error code = %d\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    event.data.fd = timer_fd;
+    if (epoll_ctl(poll_fd, EPOLL_CTL_ADD, timer_fd, &event) != 0) {
+        log_message("Could not watch timer, error code = %d\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    log_message("Consumer thread started\n");
+
+    while (item_index < item_count) {
+        if (epoll_wait(poll_fd, &event, 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_message("Could not wait for events, error code = %d\n", errno);
+            exit(EXIT_FAILURE);
+        }
+        if (event.data.fd == timer_fd) {
+            if (read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                ticks += expirations;
+            }
+            continue;
+        }
+        wakeups++;
+
+        // drain the ring, arm the notifier once it is empty and look once more for an item published meanwhile
+        armed = 0;
+        while (item_index < item_count) {
+            if (spsc_ring_try_pop(&ring, &item)) {
+                consume_item(item);
+                if (!quiet) {
+                    log_message("Consumed %llu\n", item_index);
+                }
+                item_index = (item_index + 1);
+            } else if (armed) {
+                break;
+            } else {
+                event_notifier_arm(&ring_events);
+                armed = 1;
+            }
+        }
+    }
+
+    log_message("Consumer woke up %llu times for items and %llu times for the timer\n", wakeups, ticks);
+    close(timer_fd);
+    close(poll_fd);
+    return NULL;
+}
+
+/***
+ * The producer function for the lock-free SPSC mode when items are moved in batches
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *spsc_batch_producer(void *dummy) {
+    unsigned long long item_index = 0;
+    size_t batch_count;
+    long double *items = (long double *) malloc(sizeof(long double) * batch_size);
+    if (items == NULL) {
+        log_message("Could not allocate memory for producer batch\n");
+        exit(EXIT_FAILURE);
+    }
+    log_message("Producer thread started\n");
+
+    do {
+        // produce a batch of items, the last batch may be short
+        batch_count = (item_count - item_index < batch_size) ? (size_t) (item_count - item_index) : batch_size;
+        produce_items(items, item_index, batch_count);
+
+        // wait for free slots and publish the batch
+        spsc_ring_push_batch(&ring, items, batch_count);
+
+        if (!quiet) {
+            log_message("Produced %llu to %llu\n", item_index, item_index + batch_count - 1);
+        }
+        item_index = (item_index + batch_count);
+    } while (item_index < item_count);
+
+    free(items);
+    return NULL;
+}
+
+/***
+ * The consumer function for the lock-free SPSC mode when items are moved in batches
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *spsc_batch_consumer(void *dummy) {
+    unsigned long long item_index = 0;
+    size_t batch_index, batch_count;
+    long double *items = (long double *) malloc(sizeof(long double) * batch_size);
+    if (items == NULL) {
+        log_message("Could not allocate memory for consumer batch\n");
+        exit(EXIT_FAILURE);
+    }
+    log_message("Consumer thread started\n");
+
+    do {
+        // wait for items and drain everything available up to a batch
+        batch_count = spsc_ring_pop_batch(&ring, items, batch_size);
+        for (batch_index = 0; batch_index < batch_count; batch_index++) {
+            consume_item(items[batch_index]);
+        }
+
+        if (!quiet) {
+            log_message("Consumed %llu to %llu\n", item_index, item_index + batch_count - 1);
+        }
+        item_index = (item_index + batch_count);
+    } while (item_index < item_count);
+
+    free(items);
+    return NULL;
+}
+
+/***
+ * Append an item to the queue of the mpmc mode, with -T giving up at every deadline to count the stall in the
+ * statistics of the queue before waiting again
+ * @param item the item to append
+ */
+void mpmc_buffer_push(long double item) {
+    struct timespec deadline;
+
+    if (wait_timeout == 0) {
+        mpmc_queue_push(&queue, item);
+        return;
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (mpmc_queue_timed_push(&queue, item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+}
+
+/***
+ * Remove an item from the queue of the mpmc mode, with -T giving up at every deadline to count the stall in the
+ * statistics of the queue before waiting again
+ * @return the removed item
+ */
+long double mpmc_buffer_pop(void) {
+    struct timespec deadline;
+    long double item;
+
+    if (wait_timeout == 0) {
+        return mpmc_queue_pop(&queue);
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (mpmc_queue_timed_pop(&queue, &item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+    return item;
+}
+
+/***
+ * The producer function for the lock-free MPMC mode
+ * @param id the index of the producer thread
+ * @return NULL
+ */
+void *mpmc_producer(void *id) {
+    int producer_id = (int) (intptr_t) id;
+    unsigned long long item_index = 0;
+    log_message("Producer thread %d started\n", producer_id);
+
+    do {
+        // produce the item to be stored in the buffer
+        long double item = produce_item(item_index);
+
+        // wait for a free slot and publish the item
+        mpmc_buffer_push(item);
+
+        if (!quiet) {
+            log_message("Producer %d produced %llu\n", producer_id, item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count);
+
+    return NULL;
+}
+
+/***
+ * The consumer function for the lock-free MPMC mode
+ * @param id the index of the consumer thread
+ * @return NULL
+ */
+void *mpmc_consumer(void *id) {
+    int consumer_id = (int) (intptr_t) id;
+    unsigned long long total_items = (unsigned long long) producer_count * item_count;
+    log_message("Consumer thread %d started\n", consumer_id);
+
+    // every claim below total_items is matched by exactly one item from some producer
+    while (atomic_fetch_add(&items_claimed, 1) < total_items) {
+        // wait for an item and hand its slot back to the producers
+        consume_item(mpmc_buffer_pop());
+
+        if (!quiet) {
+            log_message("Consumer %d consumed an item\n", consumer_id);
+        }
+    }
+
+    return NULL;
+}
+
+/***
+ * Append an item to the shared memory ring, with -T giving up at every deadline to count the stall in the statistics of
+ * the ring before waiting again
+ * @param item the item to append
+ */
+void shm_buffer_push(long double item) {
+    struct timespec deadline;
+
+    if (wait_timeout == 0) {
+        shm_ring_push(&shm_ring, item);
+        return;
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (shm_ring_timed_push(&shm_ring, item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+}
+
+/***
+ * The producer function for the shared memory mode, runs in a process of its own
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *shm_producer(void *dummy) {
+    unsigned long long item_index = 0;
+    log_message("Producer process started\n");
+
+    do {
+        // produce the item to be stored in the buffer
+        long double item = produce_item(item_index);
+
+        // wait for a free slot and publish the item to the other process
+        shm_buffer_push(item);
+
+        if (!quiet) {
+            log_message("Produced %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count);
+
+    return NULL;
+}
+
+/***
+ * Check without waiting whether the producer process of the shm mode has exited, and reap it if it has
+ * @return 1 if the producer process has exited, 0 if it is still running
+ */
+int producer_process_exited(void) {
+    if (!producer_reaped && waitpid(producer_process, &producer_status, WNOHANG) == producer_process) {
+        producer_reaped = 1;
+    }
+    return producer_reaped;
+}
+
+/***
+ * Remove the name of the shared memory ring when the consumer process exits before the producer process removed it,
+ * so that a failed run leaves nothing behind in /dev/shm, registered with atexit
+ */
+void unlink_shm_ring(void) {
+    // the producer process inherits the handler and removes the name itself, a name that is gone already is fine
+    if (producer_process != 0) {
+        shm_ring_unlink(shm_name);
+    }
+}
+
+/***
+ * The consumer function for the shared memory mode
+ * @param dummy dummy parameter
+ * @return NULL
+ */
+void *shm_consumer(void *dummy) {
+    unsigned long long item_index = 0;
+    uint64_t check_interval = (wait_timeout != 0) ? wait_timeout : PRODUCER_CHECK_INTERVAL;
+    struct timespec deadline;
+    long double item;
+    int exited = 0;
+    log_message("Consumer thread started\n");
 
-#define MAX_BUFFER_SIZE 100
+    do {
+        // wait for an item and hand its slot back to the producer process, looking after the producer at every
+        // deadline since a process that died would never wake us. Items it published before it exited are still
+        // in the ring, so we only give up once the ring stays empty after the exit
+        wait_deadline_after(&deadline, check_interval);
+        while (shm_ring_timed_pop(&shm_ring, &item, &deadline) == ETIMEDOUT) {
+            if (exited) {
+                log_message("Producer process exited before producing item %llu\n", item_index);
+                exit(EXIT_FAILURE);
+            }
+            exited = producer_process_exited();
+            wait_deadline_after(&deadline, check_interval);
+        }
+        consume_item(item);
+
+        if (!quiet) {
+            log_message("Consumed %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count);
+
+    return NULL;
+}
 
 /***
- * bounded buffer to store the elements
+ * Run the producer in a child process, which maps the shared memory ring by its name like an unrelated process
+ * would, and exit
+ * @param consumer_process the process of the consumer, which forked the producer process
  */
-long double *buffer;
+void run_producer_process(pid_t consumer_process) {
+    int error_code;
+
+    // a producer whose consumer died would wait for a free slot forever, so die with it
+    if (prctl(PR_SET_PDEATHSIG, SIGKILL) != 0 || getppid() != consumer_process) {
+        exit(EXIT_FAILURE);
+    }
+
+    error_code = thread_placement_configure_self((thread_cpus != NULL) ? thread_cpus[0] : -1, &thread_schedule);
+    if (error_code != 0) {
+        printf("Could not place producer process, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+
+    error_code = shm_ring_close(&shm_ring);
+    if (error_code == 0) {
+        error_code = shm_ring_open(&shm_ring, shm_name);
+    }
+    if (error_code != 0) {
+        printf("Could not open shared memory ring, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+
+    // both processes map the ring now, so the name can go before either of them dies and leaves it behind
+    error_code = shm_ring_unlink(shm_name);
+    if (error_code != 0) {
+        printf("Could not unlink shared memory ring, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+
+    shm_producer(NULL);
+
+    error_code = shm_ring_close(&shm_ring);
+    if (error_code != 0) {
+        printf("Could not close shared memory ring, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
 
 /***
- * The required counting semaphores
+ * Append an item to the persistent ring of the file mode, with -T giving up at every deadline to count the stall in the
+ * statistics of the ring before waiting again
+ * @param item the item to append
  */
-sem_t empty_semaphore, full_semaphore;
+void file_buffer_push(long double item) {
+    struct timespec deadline;
+
+    if (wait_timeout == 0) {
+        file_ring_push(&file_ring, item);
+        return;
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (file_ring_timed_push(&file_ring, item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+}
 
 /***
- * The required mutex lock
+ * Remove an item from the persistent ring of the file mode, with -T giving up at every deadline to count the stall in
+ * the statistics of the ring before waiting again
+ * @return the removed item
  */
-pthread_mutex_t lock;
+long double file_buffer_pop(void) {
+    struct timespec deadline;
+    long double item;
 
-/**
- * Method to simulate a long running process synomous to "prodcing" an item
- * @param number a random integer
- * @return a really long number
+    if (wait_timeout == 0) {
+        return file_ring_pop(&file_ring);
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (file_ring_timed_pop(&file_ring, &item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+    return item;
+}
+
+/***
+ * The producer function for the file mode
+ * @param dummy dummy parameter
+ * @return NULL
  */
-long double produce_item(int number) {
-    return (number == 0) ? 1 : number * produce_item(number - 1);
+void *file_producer(void *dummy) {
+    unsigned long long item_index = 0;
+    log_message("Producer thread started\n");
+
+    do {
+        // produce the item to be stored in the buffer
+        long double item = produce_item(item_index);
+
+        // wait for a free slot, publish the item and commit it to the file as the sync policy says
+        file_buffer_push(item);
+
+        if (!quiet) {
+            log_message("Produced %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count);
+
+    return NULL;
 }
 
 /***
- * The producer function
+ * The consumer function for the file mode, which consumes the items recovered from the file before the new ones
  * @param dummy dummy parameter
  * @return NULL
  */
-void *producer(void *dummy) {
-    int buffer_index = 0;
-    printf("Producer thread started\n");
+void *file_consumer(void *dummy) {
+    unsigned long long item_index = 0;
+    log_message("Consumer thread started\n");
+
+    do {
+        // wait for an item and hand its slot back to the producer
+        consume_item(file_buffer_pop());
+
+        if (!quiet) {
+            log_message("Consumed %llu\n", item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count + file_ring.recovered);
+
+    return NULL;
+}
+
+/***
+ * Place the worker threads with the autotuner, measuring the core-to-core latency or loading it from a file
+ * @param path the file the matrix is kept in, measured and saved when it does not exist yet, NULL to always measure
+ * @return 0 on success, an error number otherwise
+ */
+int tune_placement(const char *path) {
+    core_latency_matrix_t matrix;
+    int error_code = (path != NULL) ? core_latency_load(&matrix, path) : ENOENT;
+
+    if (error_code == ENOENT) {
+        printf("Measuring core-to-core latency\n");
+        error_code = core_latency_measure(&matrix, DEFAULT_PROBE_ROUND_TRIPS);
+        if (error_code == 0 && path != NULL) {
+            error_code = core_latency_save(&matrix, path);
+            if (error_code != 0) {
+                core_latency_destroy(&matrix);
+            }
+        }
+    }
+    if (error_code != 0) {
+        return error_code;
+    }
+
+    core_latency_print(&matrix, stdout);
+    error_code = core_latency_place(&matrix, thread_cpus, producer_count, consumer_count);
+    core_latency_destroy(&matrix);
+    return error_code;
+}
+
+/***
+ * Append an item to a lane of the sharded queue, with -T giving up at every deadline to count the stall in the
+ * statistics of the lane before waiting again
+ * @param lane the lane of the producer
+ * @param item the item to append
+ */
+void sharded_buffer_push(int lane, long double item) {
+    struct timespec deadline;
+
+    if (wait_timeout == 0) {
+        sharded_queue_push(&sharded_queue, lane, item);
+        return;
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (sharded_queue_timed_push(&sharded_queue, lane, item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+}
+
+/***
+ * Remove an item from a lane of the sharded queue, with -T giving up at every deadline to count the stall in the
+ * statistics of the lane before waiting again
+ * @param cursor the cursor of the consumer
+ * @return the removed item
+ */
+long double sharded_buffer_pop(sharded_queue_cursor_t *cursor) {
+    struct timespec deadline;
+    long double item;
+
+    if (wait_timeout == 0) {
+        return sharded_queue_pop(&sharded_queue, cursor);
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (sharded_queue_timed_pop(&sharded_queue, cursor, &item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+    return item;
+}
+
+/***
+ * The producer function for the sharded mode, every producer appends to the lane of its own index
+ * @param id the index of the producer thread
+ * @return NULL
+ */
+void *sharded_producer(void *id) {
+    int producer_id = (int) (intptr_t) id;
+    unsigned long long item_index = 0;
+    log_message("Producer thread %d started\n", producer_id);
 
     do {
         // produce the item to be stored in the buffer
-        long double item = produce_item(buffer_index);
+        long double item = produce_item(item_index);
 
-        // decrement the empty semaphore
-        sem_wait(&empty_semaphore);
+        // wait for a free slot in our lane and publish the item
+        sharded_buffer_push(producer_id, item);
 
-        // acquire the lock
-        pthread_mutex_lock(&lock);
+        if (!quiet) {
+            log_message("Producer %d produced %llu\n", producer_id, item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count);
 
-        buffer[buffer_index] = item;
-        printf("Produced %d\n", buffer_index);
-        buffer_index = (buffer_index + 1);
+    return NULL;
+}
 
-        // release the lock
-        pthread_mutex_unlock(&lock);
+/***
+ * The consumer function for the sharded mode
+ * @param id the index of the consumer thread
+ * @return NULL
+ */
+void *sharded_consumer(void *id) {
+    int consumer_id = (int) (intptr_t) id;
+    unsigned long long total_items = (unsigned long long) producer_count * item_count;
+    sharded_queue_cursor_t cursor;
+    log_message("Consumer thread %d started\n", consumer_id);
 
-        // increment the full semaphore
-        sem_post(&full_semaphore);
-    } while (buffer_index < MAX_BUFFER_SIZE);
+    sharded_queue_cursor_init(&sharded_queue, &cursor, consumer_id);
+
+    // every claim below total_items is matched by exactly one item from some lane
+    while (atomic_fetch_add(&items_claimed, 1) < total_items) {
+        // wait for an item in any lane and hand its slot back to the lane's producer
+        consume_item(sharded_buffer_pop(&cursor));
+
+        if (!quiet) {
+            log_message("Consumer %d consumed an item\n", consumer_id);
+        }
+    }
 
     return NULL;
 }
 
 /***
- * The consumer function
- * @param dummy dummy parameter
+ * Append an item to a lane of the priority queue, with -T giving up at every deadline to count the stall in the
+ * statistics of the lane before waiting again
+ * @param lane the priority level of the item
+ * @param item the item to append
+ */
+void priority_buffer_push(int lane, long double item) {
+    struct timespec deadline;
+
+    if (wait_timeout == 0) {
+        priority_queue_push(&priority_queue, lane, item);
+        return;
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (priority_queue_timed_push(&priority_queue, lane, item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+}
+
+/***
+ * Remove an item from a lane of the priority queue, with -T giving up at every deadline to count the stall in the
+ * statistics of the lane before waiting again
+ * @param cursor the cursor of the consumer
+ * @return the removed item
+ */
+long double priority_buffer_pop(priority_queue_cursor_t *cursor) {
+    struct timespec deadline;
+    long double item;
+
+    if (wait_timeout == 0) {
+        return priority_queue_pop(&priority_queue, cursor);
+    }
+
+    wait_deadline_after(&deadline, wait_timeout);
+    while (priority_queue_timed_pop(&priority_queue, cursor, &item, &deadline) == ETIMEDOUT) {
+        wait_deadline_after(&deadline, wait_timeout);
+    }
+    return item;
+}
+
+/***
+ * The producer function for the priority mode, every producer appends to the lane of its index modulo the number of
+ * lanes
+ * @param id the index of the producer thread
  * @return NULL
  */
-void *consumer(void *dummy) {
-    int buffer_index = 0;
-    printf("Consumer thread started\n");
+void *priority_producer(void *id) {
+    int producer_id = (int) (intptr_t) id, lane = producer_id % priority_lane_count;
+    unsigned long long item_index = 0;
+    log_message("Producer thread %d started on lane %d\n", producer_id, lane);
 
     do {
-        // decrement the full semaphore
-        sem_wait(&full_semaphore);
+        // produce the item to be stored in the buffer
+        long double item = produce_item(item_index);
 
-        // acquire the lock
-        pthread_mutex_lock(&lock);
+        // wait for a free slot in our lane and publish the item
+        priority_buffer_push(lane, item);
 
-        printf("Consumed %d\n", buffer_index);
-        buffer_index = (buffer_index + 1);
+        if (!quiet) {
+            log_message("Producer %d produced %llu\n", producer_id, item_index);
+        }
+        item_index = (item_index + 1);
+    } while (item_index < item_count);
 
-        // release the lock
-        pthread_mutex_unlock(&lock);
+    return NULL;
+}
 
-        // increment the empty semaphore
-        sem_post(&empty_semaphore);
-    } while (buffer_index < MAX_BUFFER_SIZE);
+/***
+ * The consumer function for the priority mode
+ * @param id the index of the consumer thread
+ * @return NULL
+ */
+void *priority_consumer(void *id) {
+    int consumer_id = (int) (intptr_t) id;
+    unsigned long long total_items = (unsigned long long) producer_count * item_count;
+    priority_queue_cursor_t cursor;
+    log_message("Consumer thread %d started\n", consumer_id);
+
+    priority_queue_cursor_init(&priority_queue, &cursor);
+
+    // every claim below total_items is matched by exactly one item from some lane
+    while (atomic_fetch_add(&items_claimed, 1) < total_items) {
+        // wait for an item in the lane the policy picks and hand its slot back to the producers
+        consume_item(priority_buffer_pop(&cursor));
+
+        if (!quiet) {
+            log_message("Consumer %d consumed an item\n", consumer_id);
+        }
+    }
 
     return NULL;
 }
 
+/***
+ * Print the command line usage
+ * @param program the name of the executable
+ */
+void print_usage(const char *program) {
+    printf("Usage: %s [-m semaphore|futex|spsc|mpmc|shm|file|sharded|sharded-drain|priority|"
+           "priority-wrr] [-p producers] [-c consumers] [-n items] [-b batch] [-w spin,yield] [-l raw|tsc]"
+           " [-x range] [-F path] [-S sync] [-M memory] [-A cpus] [-P policy] [-k deque] [-L weights] [-T us]"
+           " [-E] [-a] [-q]\n", program);
+    printf("  -m  synchronization mode, semaphore (default), futex semaphore, lock-free spsc, lock-free mpmc,"
+           " lock-free spsc in shared memory between a producer and a consumer process or lock-free spsc in a"
+           " memory-mapped file that keeps the pending items across runs, or a lock-free spsc lane per producer"
+           " that consumers visit in turn, moving on after every item or after draining the lane, or a lock-free mpmc"
+           " lane per priority level that consumers take from by strict priority or weighted round robin\n");
+    printf("  -p  number of producer threads, mpmc, sharded and priority modes only (default 1)\n");
+    printf("  -c  number of consumer threads, mpmc, sharded and priority modes or semaphore mode with -k only"
+           " (default 1)\n");
+    printf("  -n  number of items produced by each producer (default %d)\n", MAX_BUFFER_SIZE);
+    printf("  -b  number of items moved per synchronization, spsc mode only (default 1)\n");
+    printf("  -w  pause iterations and yields before a waiting thread parks, every mode but semaphore"
+           " (default %d,%d)\n", DEFAULT_SPIN_LIMIT, DEFAULT_YIELD_LIMIT);
+    printf("  -l  record the time every item spends in the buffer, measured with CLOCK_MONOTONIC_RAW or the time"
+           " stamp counter\n");
+    printf("  -x  produce the exact factorials of the item index modulo range instead of long doubles\n");
+    printf("  -F  path of the file of the file mode (default bounded_buffer.ring)\n");
+    printf("  -S  when the file mode writes items back to disk, none (default), item, every N items or every N"
+           " milliseconds with Nms\n");
+    printf("  -M  comma separated buffer memory options out of hugetlb, thp, prefault and node=N\n");
+    printf("  -A  pin the producers and then the consumers to a comma separated list of CPUs, auto to place each"
+           " producer next to its consumer on cores that share a cache, or tune[=path] to place them on the cores"
+           " with the lowest measured handoff latency, keeping the measurement in path\n");
+    printf("  -P  scheduling policy of the worker threads, other or fifo:priority\n");
+    printf("  -k  consume with a work-stealing pool whose workers take batches from the buffer into local deques of"
+           " this many items and steal half of the busiest deque when idle, semaphore mode only\n");
+    printf("  -L  comma separated weights of the priority lanes, most urgent first, producer i feeds lane i modulo"
+           " the number of lanes, priority modes only (default 4,1)\n");
+    printf("  -T  give up a wait for the buffer after this many microseconds, count it and wait again, not with"
+           " batches\n");
+    printf("  -E  let the consumer wait for the ring in epoll on an eventfd next to a timer, spsc mode only\n");
+    printf("  -a  print from the worker threads through the asynchronous logger\n");
+    printf("  -q  do not print a line for every item\n");
+}
+
+/***
+ * Parse the command line arguments
+ * @param argc number of arguments
+ * @param argv the arguments
+ */
+void parse_arguments(int argc, char *argv[]) {
+    int option;
+    unsigned int spin_limit, yield_limit;
+
+    while ((option = getopt(argc, argv, "m:p:c:n:b:w:l:x:F:S:M:A:P:k:L:T:Eaqh")) != -1) {
+        switch (option) {
+            case 'm':
+                if (strcmp(optarg, "semaphore") == 0) {
+                    mode = MODE_SEMAPHORE;
+                } else if (strcmp(optarg, "futex") == 0) {
+                    mode = MODE_FUTEX;
+                } else if (strcmp(optarg, "spsc") == 0) {
+                    mode = MODE_SPSC;
+                } else if (strcmp(optarg, "mpmc") == 0) {
+                    mode = MODE_MPMC;
+                } else if (strcmp(optarg, "shm") == 0) {
+                    mode = MODE_SHM;
+                } else if (strcmp(optarg, "file") == 0) {
+                    mode = MODE_FILE;
+                } else if (strcmp(optarg, "sharded") == 0) {
+                    mode = MODE_SHARDED;
+                    sharded_policy = SHARDED_QUEUE_ROUND_ROBIN;
+                } else if (strcmp(optarg, "sharded-drain") == 0) {
+                    mode = MODE_SHARDED;
+                    sharded_policy = SHARDED_QUEUE_DRAIN;
+                } else if (strcmp(optarg, "priority") == 0) {
+                    mode = MODE_PRIORITY;
+                    priority_policy = PRIORITY_QUEUE_STRICT;
+                } else if (strcmp(optarg, "priority-wrr") == 0) {
+                    mode = MODE_PRIORITY;
+                    priority_policy = PRIORITY_QUEUE_WEIGHTED;
+                } else {
+                    printf("Unknown mode %s\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'p':
+                producer_count = atoi(optarg);
+                break;
+            case 'c':
+                consumer_count = atoi(optarg);
+                break;
+            case 'n':
+                item_count = strtoull(optarg, NULL, 10);
+                break;
+            case 'b':
+                batch_size = (size_t) strtoull(optarg, NULL, 10);
+                break;
+            case 'k':
+                deque_capacity = (size_t) strtoull(optarg, NULL, 10);
+                break;
+            case 'T':
+                wait_timeout = strtoull(optarg, NULL, 10) * 1000ULL;
+                break;
+            case 'L':
+                if (priority_queue_parse_weights(optarg, priority_weights, MAX_PRIORITY_LANES,
+                                                 &priority_lane_count) != 0) {
+                    printf("Invalid lane weights %s\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'w':
+                if (sscanf(optarg, "%u,%u", &spin_limit, &yield_limit) != 2) {
+                    printf("Invalid wait strategy %s\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                wait_strategy_configure(spin_limit, yield_limit);
+                break;
+            case 'l':
+                if (strcmp(optarg, "raw") == 0) {
+                    latency_clock = LATENCY_CLOCK_MONOTONIC_RAW;
+                } else if (strcmp(optarg, "tsc") == 0) {
+                    latency_clock = LATENCY_CLOCK_TSC;
+                } else {
+                    printf("Unknown clock %s\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                latency_enabled = 1;
+                break;
+            case 'x':
+                exact_range = (unsigned int) strtoul(optarg, NULL, 10);
+                if (exact_range < 1) {
+                    printf("The exact range must be at least 1\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'F':
+                file_path = optarg;
+                break;
+            case 'S':
+                if (file_ring_parse_sync(optarg, &file_sync, &file_sync_period) != 0) {
+                    printf("Invalid sync policy %s\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'M':
+                if (buffer_memory_parse(optarg, &memory_policy) != 0) {
+                    printf("Invalid buffer memory options %s\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'A':
+                placement = optarg;
+                break;
+            case 'P':
+                if (thread_placement_parse_schedule(optarg, &thread_schedule) != 0) {
+                    printf("Invalid scheduling policy %s\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'E':
+                event_driven = 1;
+                break;
+            case 'a':
+                async_logging = 1;
+                break;
+            case 'q':
+                quiet = 1;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                exit(EXIT_SUCCESS);
+            default:
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (item_count < 1) {
+        printf("The number of items must be at least 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (batch_size < 1) {
+        printf("The batch size must be at least 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (mode != MODE_SPSC && batch_size != 1) {
+        printf("Only the spsc mode supports batches\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (producer_count < 1 || consumer_count < 1) {
+        printf("The number of producers and consumers must be at least 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (batch_size != 1 && wait_timeout != 0) {
+        printf("Batches do not support wait timeouts\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (mode != MODE_SPSC && event_driven) {
+        printf("Only the spsc mode supports waiting in epoll\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (mode != MODE_SEMAPHORE && deque_capacity != 0) {
+        printf("Only the semaphore mode supports a work-stealing pool\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // the pool takes the place of the single consumer, the producer side stays the same
+    if (mode != MODE_MPMC && mode != MODE_SHARDED && mode != MODE_PRIORITY &&
+        (producer_count != 1 || (consumer_count != 1 && deque_capacity == 0))) {
+        printf("Only the mpmc, sharded and priority modes support more than one producer or consumer, and the"
+               " semaphore mode more than one consumer with -k\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // latency stamps, the logger thread and the exact item pool all live in the memory of a single process
+    if (mode == MODE_SHM && (latency_enabled || async_logging || exact_range != 0)) {
+        printf("The shm mode does not support -l, -a or -x\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // latency stamps and exact item handles would not mean anything to the run that recovers the items
+    if (mode == MODE_FILE && (latency_enabled || exact_range != 0)) {
+        printf("The file mode does not support -l or -x\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
 /***
  * Main function
+ * @param argc number of arguments
+ * @param argv the arguments
  * @return error code
  */
-int main() {
-    int error_code;
-    pthread_t producer_thread, consumer_thread;
+int main(int argc, char *argv[]) {
+    int error_code, thread_index, cpu_count;
+    pthread_t *producer_threads, *consumer_threads;
     pthread_attr_t producer_attr, consumer_attr;
+    wait_statistics_t producer_statistics;
+    pid_t consumer_process;
+    void *(*producer_function)(void *) = producer;
+    void *(*consumer_function)(void *) = consumer;
+
+    parse_arguments(argc, argv);
+
+    // place the worker threads and check if the placement was successful, unless a node was given the buffer
+    // memory is bound to the node of the first consumer
+    if (placement != NULL) {
+        thread_cpus = (int *) malloc(sizeof(int) * (producer_count + consumer_count));
+        if (thread_cpus == NULL) {
+            printf("Could not allocate memory for thread placement\n");
+            exit(EXIT_FAILURE);
+        }
+        if (strcmp(placement, "auto") == 0) {
+            error_code = thread_placement_default(thread_cpus, producer_count, consumer_count);
+        } else if (strncmp(placement, "tune", 4) == 0 && (placement[4] == '\0' || placement[4] == '=')) {
+            error_code = tune_placement((placement[4] == '=') ? placement + 5 : NULL);
+        } else {
+            error_code = thread_placement_parse_cpus(placement, thread_cpus, producer_count + consumer_count,
+                                                     &cpu_count);
+            if (error_code == 0 && cpu_count != producer_count + consumer_count) {
+                error_code = EINVAL;
+            }
+        }
+        if (error_code != 0) {
+            printf("Could not place worker threads, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+
+        for (thread_index = 0; thread_index < producer_count + consumer_count; thread_index++) {
+            printf("%s %d on CPU %d\n", (thread_index < producer_count) ? "Producer" : "Consumer",
+                   (thread_index < producer_count) ? thread_index : thread_index - producer_count,
+                   thread_cpus[thread_index]);
+        }
+        if (memory_policy.node < 0) {
+            memory_policy.node = thread_placement_node(thread_cpus[producer_count]);
+        }
+    }
+    buffer_memory_configure(&memory_policy);
+
+    // initialize the latency histograms and check if the initialization was successful, the lanes of the priority
+    // mode record into histograms of their own
+    if (latency_enabled && mode != MODE_PRIORITY) {
+        error_code = latency_recorder_init(&latency, latency_clock);
+        if (error_code != 0) {
+            printf("Could not initialize latency histograms, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // initialize the pool of exact items and check if the initialization was successful, it holds enough numbers
+    // to fill the buffer while every thread holds a batch
+    if (exact_range != 0) {
+        error_code = bignum_pool_init(&bignum_pool, round_up_power_of_two(MAX_BUFFER_SIZE) +
+                                                    (size_t) (producer_count + consumer_count) * batch_size);
+        if (error_code != 0) {
+            printf("Could not initialize exact item pool, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // initialize the futex semaphores and check if the initialization was successful
+    if (mode == MODE_FUTEX) {
+        error_code = futex_semaphore_init(&full_futex_semaphore, 0);
+        if (error_code != 0) {
+            printf("Could not initialize full futex semaphore, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        error_code = futex_semaphore_init(&empty_futex_semaphore, MAX_BUFFER_SIZE);
+        if (error_code != 0) {
+            printf("Could not initialize empty futex semaphore, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        producer_function = futex_producer;
+        consumer_function = futex_consumer;
+    }
+
+    // initialize the queue with a lane per priority level and check if the initialization was successful, every
+    // lane records its own latencies
+    if (mode == MODE_PRIORITY) {
+        error_code = priority_queue_init(&priority_queue, priority_lane_count, MAX_BUFFER_SIZE, priority_weights,
+                                         priority_policy);
+        if (error_code == 0 && latency_enabled) {
+            error_code = priority_queue_enable_latency(&priority_queue, latency_clock);
+        }
+        if (error_code != 0) {
+            printf("Could not initialize priority queue, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        atomic_init(&items_claimed, 0);
+        producer_function = priority_producer;
+        consumer_function = priority_consumer;
+    }
+
+    // initialize the work-stealing pool of the consumers and check if the initialization was successful
+    if (deque_capacity > 0) {
+        error_code = work_pool_init(&work_pool, consumer_count, deque_capacity);
+        if (error_code != 0) {
+            printf("Could not initialize work-stealing pool, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        atomic_init(&items_consumed, 0);
+        consumer_function = pool_consumer;
+    }
+
+    // initialize the lock-free ring and check if the initialization was successful
+    if (mode == MODE_SPSC) {
+        error_code = spsc_ring_init(&ring, MAX_BUFFER_SIZE);
+        if (error_code == 0 && latency_enabled) {
+            error_code = spsc_ring_enable_latency(&ring, &latency);
+        }
+        if (error_code != 0) {
+            printf("Could not initialize ring buffer, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        producer_function = (batch_size > 1) ? spsc_batch_producer : spsc_producer;
+        consumer_function = (batch_size > 1) ? spsc_batch_consumer : spsc_consumer;
+    }
+
+    // create the eventfd of the ring and check if the creation was successful
+    if (event_driven) {
+        error_code = event_notifier_init(&ring_events);
+        if (error_code != 0) {
+            printf("Could not create event notifier, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        spsc_ring_enable_events(&ring, &ring_events);
+        consumer_function = event_consumer;
+    }
+
+    // initialize the lock-free queue and check if the initialization was successful
+    if (mode == MODE_MPMC) {
+        error_code = mpmc_queue_init(&queue, MAX_BUFFER_SIZE);
+        if (error_code == 0 && latency_enabled) {
+            error_code = mpmc_queue_enable_latency(&queue, &latency);
+        }
+        if (error_code != 0) {
+            printf("Could not initialize queue, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        atomic_init(&items_claimed, 0);
+        producer_function = mpmc_producer;
+        consumer_function = mpmc_consumer;
+    }
+
+    // initialize the sharded queue with a lane per producer and check if the initialization was successful
+    if (mode == MODE_SHARDED) {
+        error_code = sharded_queue_init(&sharded_queue, producer_count, MAX_BUFFER_SIZE, consumer_count,
+                                        sharded_policy);
+        if (error_code == 0 && latency_enabled) {
+            error_code = sharded_queue_enable_latency(&sharded_queue, &latency);
+        }
+        if (error_code != 0) {
+            printf("Could not initialize sharded queue, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        atomic_init(&items_claimed, 0);
+        producer_function = sharded_producer;
+        consumer_function = sharded_consumer;
+    }
+
+    // create the shared memory ring and check if the creation was successful, then start the producer process
+    // before any other thread exists so that the child inherits no locks held by them
+    if (mode == MODE_SHM) {
+        snprintf(shm_name, sizeof(shm_name), "/bounded_buffer_%d", (int) getpid());
+        error_code = shm_ring_create(&shm_ring, shm_name, MAX_BUFFER_SIZE);
+        if (error_code != 0) {
+            printf("Could not create shared memory ring, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        atexit(unlink_shm_ring);
+
+        fflush(stdout);
+        consumer_process = getpid();
+        producer_process = fork();
+        if (producer_process < 0) {
+            printf("Could not create producer process, error code = %d\n", errno);
+            exit(EXIT_FAILURE);
+        }
+        if (producer_process == 0) {
+            run_producer_process(consumer_process);
+        }
+        consumer_function = shm_consumer;
+    }
+
+    // open the persistent ring and check if it was successful, the items a previous run left in it are consumed
+    // before the new ones
+    if (mode == MODE_FILE) {
+        error_code = file_ring_open(&file_ring, file_path, MAX_BUFFER_SIZE, file_sync, file_sync_period);
+        if (error_code != 0) {
+            printf("Could not open file ring %s, error code = %d\n", file_path, error_code);
+            exit(EXIT_FAILURE);
+        }
+        if (file_ring.recovered > 0) {
+            printf("Recovered %zu items from %s\n", file_ring.recovered, file_path);
+        }
+        producer_function = file_producer;
+        consumer_function = file_consumer;
+    }
 
-    // dynamically allocate memory for buffer and check if allocation was successful
-    buffer = (long double *) malloc(sizeof(long double) * MAX_BUFFER_SIZE);
-    if (buffer == NULL) {
-        printf("Could not allocate memory for buffer\n");
+    // dynamically allocate memory for the thread handles and check if allocation was successful
+    producer_threads = (pthread_t *) malloc(sizeof(pthread_t) * producer_count);
+    consumer_threads = (pthread_t *) malloc(sizeof(pthread_t) * consumer_count);
+    if (producer_threads == NULL || consumer_threads == NULL) {
+        printf("Could not allocate memory for thread handles\n");
         exit(EXIT_FAILURE);
     }
 
+    // map memory for buffer with the buffer memory policy and check if the mapping was successful
+    buffer_mask = round_up_power_of_two(MAX_BUFFER_SIZE) - 1;
+    error_code = buffer_memory_allocate((void **) &buffer, sizeof(long double) * (buffer_mask + 1));
+    if (error_code != 0) {
+        printf("Could not allocate memory for buffer, error code = %d\n", error_code);
+        exit(EXIT_FAILURE);
+    }
+
+    // dynamically allocate memory for the publish times of the buffer slots and check if allocation was successful
+    if (latency_enabled) {
+        buffer_stamps = (uint64_t *) malloc(sizeof(uint64_t) * (buffer_mask + 1));
+        if (buffer_stamps == NULL) {
+            printf("Could not allocate memory for buffer time stamps\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // initialize the mutex lock and check if the initialization was successful
     error_code = pthread_mutex_init(&lock, NULL);
     if (error_code != 0) {
@@ -151,32 +1896,135 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
-    // create and start the consumer thread and check if the creation and starting of thread was successful
-    error_code = pthread_create(&consumer_thread, &consumer_attr, consumer, NULL);
-    if (error_code != 0) {
-        printf("Could not create consumer thread, error code = %d\n", error_code);
-        exit(EXIT_FAILURE);
+    // start the asynchronous logger and check if it was successful, stdout is flushed first since the logger
+    // writes to its file descriptor directly
+    if (async_logging) {
+        fflush(stdout);
+        error_code = async_logger_init(&logger, STDOUT_FILENO, 0);
+        if (error_code != 0) {
+            printf("Could not start asynchronous logger, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
     }
 
-    // create and start the producer thread and check if the creation and starting of thread was successful
-    error_code = pthread_create(&producer_thread, &producer_attr, producer, NULL);
-    if (error_code != 0) {
-        printf("Could not create producer thread, error code = %d\n", error_code);
-        exit(EXIT_FAILURE);
+    // create and start the consumer threads and check if the creation and starting of threads was successful
+    for (thread_index = 0; thread_index < consumer_count; thread_index++) {
+        error_code = thread_placement_configure_attr(&consumer_attr, (thread_cpus != NULL) ?
+                                                     thread_cpus[producer_count + thread_index] : -1,
+                                                     &thread_schedule);
+        if (error_code != 0) {
+            printf("Could not configure consumer thread attributes, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        error_code = pthread_create(&consumer_threads[thread_index], &consumer_attr, consumer_function,
+                                    (void *) (intptr_t) thread_index);
+        if (error_code != 0) {
+            printf("Could not create consumer thread, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
     }
 
-    // wait for the producer thread to finish
-    error_code = pthread_join(producer_thread, NULL);
-    if (error_code != 0) {
-        printf("Could not join with producer thread, error code = %d\n", error_code);
-        exit(EXIT_FAILURE);
+    // create and start the producer threads and check if the creation and starting of threads was successful, the
+    // producer process of the shm mode is already running
+    for (thread_index = 0; thread_index < producer_count && mode != MODE_SHM; thread_index++) {
+        error_code = thread_placement_configure_attr(&producer_attr, (thread_cpus != NULL) ?
+                                                     thread_cpus[thread_index] : -1, &thread_schedule);
+        if (error_code != 0) {
+            printf("Could not configure producer thread attributes, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+        error_code = pthread_create(&producer_threads[thread_index], &producer_attr, producer_function,
+                                    (void *) (intptr_t) thread_index);
+        if (error_code != 0) {
+            printf("Could not create producer thread, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
     }
 
-    // wait for the consumer thread to finish
-    error_code = pthread_join(consumer_thread, NULL);
-    if (error_code != 0) {
-        printf("Could not join with consumer thread, error code = %d\n", error_code);
-        exit(EXIT_FAILURE);
+    // wait for the producer threads to finish
+    for (thread_index = 0; thread_index < producer_count && mode != MODE_SHM; thread_index++) {
+        error_code = pthread_join(producer_threads[thread_index], NULL);
+        if (error_code != 0) {
+            printf("Could not join with producer thread, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // wait for the consumer threads to finish
+    for (thread_index = 0; thread_index < consumer_count; thread_index++) {
+        error_code = pthread_join(consumer_threads[thread_index], NULL);
+        if (error_code != 0) {
+            printf("Could not join with consumer thread, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // wait for the producer process to finish and check if it was successful
+    if (mode == MODE_SHM) {
+        if (!producer_reaped && waitpid(producer_process, &producer_status, 0) < 0) {
+            printf("Could not wait for producer process, error code = %d\n", errno);
+            exit(EXIT_FAILURE);
+        }
+        if (!WIFEXITED(producer_status) || WEXITSTATUS(producer_status) != EXIT_SUCCESS) {
+            printf("Producer process failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // write the pending output of the worker threads and stop the asynchronous logger
+    if (async_logging) {
+        error_code = async_logger_destroy(&logger);
+        if (error_code != 0) {
+            printf("Could not stop asynchronous logger, error code = %d\n", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // report which phase of the wait strategy resolved the waits
+    if (mode == MODE_SEMAPHORE && wait_timeout != 0) {
+        printf("Producer waits timed out %llu times\n", atomic_load(&producer_timeouts));
+
+        // the workers of the pool never wait on the semaphore, their timeouts are in the statistics of the pool
+        if (deque_capacity == 0) {
+            printf("Consumer waits timed out %llu times\n", atomic_load(&consumer_timeouts));
+        }
+    }
+    if (deque_capacity > 0) {
+        wait_statistics_print("Consumer", &work_pool.statistics);
+        printf("Consumers stole %llu items in %llu steals\n", atomic_load(&work_pool.stolen_items),
+               atomic_load(&work_pool.steals));
+    } else if (mode == MODE_FUTEX) {
+        wait_statistics_print("Producer", &empty_futex_semaphore.statistics);
+        wait_statistics_print("Consumer", &full_futex_semaphore.statistics);
+    } else if (mode == MODE_SPSC) {
+        wait_statistics_print("Producer", &ring.producer_statistics);
+        wait_statistics_print("Consumer", &ring.consumer_statistics);
+        if (event_driven) {
+            printf("Producer signaled the eventfd %llu times\n", atomic_load(&ring_events.signals));
+        }
+    } else if (mode == MODE_MPMC) {
+        wait_statistics_print("Producer", &queue.producer_statistics);
+        wait_statistics_print("Consumer", &queue.consumer_statistics);
+    } else if (mode == MODE_SHM) {
+        wait_statistics_print("Producer", &shm_ring.control->producer_statistics);
+        wait_statistics_print("Consumer", &shm_ring.control->consumer_statistics);
+    } else if (mode == MODE_FILE) {
+        wait_statistics_print("Producer", &file_ring.producer_statistics);
+        wait_statistics_print("Consumer", &file_ring.consumer_statistics);
+    } else if (mode == MODE_SHARDED) {
+        sharded_queue_producer_statistics(&sharded_queue, &producer_statistics);
+        wait_statistics_print("Producer", &producer_statistics);
+        wait_statistics_print("Consumer", &sharded_queue.consumer_statistics);
+    } else if (mode == MODE_PRIORITY) {
+        priority_queue_producer_statistics(&priority_queue, &producer_statistics);
+        wait_statistics_print("Producer", &producer_statistics);
+        wait_statistics_print("Consumer", &priority_queue.consumer_statistics);
+        priority_queue_print(&priority_queue);
+    }
+
+    // report how long items spent in the buffer, the priority mode reported it per lane
+    if (latency_enabled && mode != MODE_PRIORITY) {
+        latency_recorder_print("Buffer", &latency);
     }
 
     // destroy the attributes for the producer thread and check if it was successful
@@ -193,8 +2041,12 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
-    // deallocate the memory allocated for the buffer
-    free(buffer);
+    // deallocate the memory allocated for the buffer and the thread handles
+    buffer_memory_free(buffer, sizeof(long double) * (buffer_mask + 1));
+    free(buffer_stamps);
+    free(producer_threads);
+    free(consumer_threads);
+    free(thread_cpus);
 
     // destroy the mutex and check if the destruction was successful
     error_code = pthread_mutex_destroy(&lock);
@@ -203,6 +2055,24 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
+    // destroy the priority queue and check if the destruction was successful
+    if (mode == MODE_PRIORITY) {
+        error_code = priority_queue_destroy(&priority_queue);
+        if (error_code != 0) {
+            printf("Could not destroy priority queue, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // destroy the work-stealing pool and check if the destruction was successful
+    if (deque_capacity > 0) {
+        error_code = work_pool_destroy(&work_pool);
+        if (error_code != 0) {
+            printf("Could not destroy work-stealing pool, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // destroy the full semaphore and check if the destruction was successful
     error_code = sem_destroy(&full_semaphore);
     if (error_code != 0) {
@@ -217,5 +2087,91 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
+    // destroy the futex semaphores and check if the destruction was successful
+    if (mode == MODE_FUTEX) {
+        error_code = futex_semaphore_destroy(&full_futex_semaphore);
+        if (error_code != 0) {
+            printf("Could not destroy full futex semaphore, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+        error_code = futex_semaphore_destroy(&empty_futex_semaphore);
+        if (error_code != 0) {
+            printf("Could not destroy empty futex semaphore, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // destroy the lock-free ring and check if the destruction was successful
+    if (mode == MODE_SPSC) {
+        error_code = spsc_ring_destroy(&ring);
+        if (error_code != 0) {
+            printf("Could not destroy ring buffer, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // close the eventfd of the ring and check if the closing was successful
+    if (event_driven) {
+        error_code = event_notifier_destroy(&ring_events);
+        if (error_code != 0) {
+            printf("Could not destroy event notifier, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // destroy the lock-free queue and check if the destruction was successful
+    if (mode == MODE_MPMC) {
+        error_code = mpmc_queue_destroy(&queue);
+        if (error_code != 0) {
+            printf("Could not destroy queue, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // destroy the sharded queue and check if the destruction was successful
+    if (mode == MODE_SHARDED) {
+        error_code = sharded_queue_destroy(&sharded_queue);
+        if (error_code != 0) {
+            printf("Could not destroy sharded queue, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // unmap the shared memory ring, whose name the producer process removed, and check if it was successful
+    if (mode == MODE_SHM) {
+        error_code = shm_ring_close(&shm_ring);
+        if (error_code != 0) {
+            printf("Could not destroy shared memory ring, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // commit the last items and close the persistent ring and check if it was successful
+    if (mode == MODE_FILE) {
+        error_code = file_ring_close(&file_ring);
+        if (error_code != 0) {
+            printf("Could not close file ring, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // destroy the pool of exact items and check if the destruction was successful
+    if (exact_range != 0) {
+        error_code = bignum_pool_destroy(&bignum_pool);
+        if (error_code != 0) {
+            printf("Could not destroy exact item pool, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // destroy the latency histograms and check if the destruction was successful
+    if (latency_enabled && mode != MODE_PRIORITY) {
+        error_code = latency_recorder_destroy(&latency);
+        if (error_code != 0) {
+            printf("Could not destroy latency histograms, error code = %d", error_code);
+            exit(EXIT_FAILURE);
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+/***
+ * Lock-free multi-producer/multi-consumer bounded queue
+ * @anchor Lalit Adithya
+ * @version 1.0
+ * @see Dmitry Vyukov, Bounded MPMC queue
+ */
+
+#include <errno.h>
+#include <stdint.h>
+
+#include "buffer_memory.h"
+#include "mpmc_queue.h"
+#include "ring_math.h"
+
+/***
+ * Context of a blocking operation
+ */
+typedef struct item_context {
+    mpmc_queue_t *queue;
+    long double *item;
+} item_context_t;
+
+int mpmc_queue_init(mpmc_queue_t *queue, size_t capacity) {
+    size_t index;
+    int error_code;
+
+    if (capacity == 0) {
+        return EINVAL;
+    }
+
+    capacity = round_up_power_of_two(capacity);
+    error_code = buffer_memory_allocate((void **) &queue->slots, sizeof(mpmc_slot_t) * capacity);
+    if (error_code != 0) {
+        return error_code;
+    }
+
+    // slot i is initially free for the producer that claims position i
+    for (index = 0; index < capacity; index++) {
+        atomic_init(&queue->slots[index].sequence, index);
+    }
+
+    queue->capacity = capacity;
+    queue->mask = capacity - 1;
+    queue->latency = NULL;
+    queue->events = NULL;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    wait_parker_init(&queue->not_full);
+    wait_parker_init(&queue->not_empty);
+    wait_statistics_init(&queue->producer_statistics);
+    wait_statistics_init(&queue->consumer_statistics);
+    return 0;
+}
+
+int mpmc_queue_enable_latency(mpmc_queue_t *queue, latency_recorder_t *recorder) {
+    queue->latency = recorder;
+    return 0;
+}
+
+void mpmc_queue_enable_events(mpmc_queue_t *queue, event_notifier_t *notifier) {
+    queue->events = notifier;
+}
+
+int mpmc_queue_destroy(mpmc_queue_t *queue) {
+    buffer_memory_free(queue->slots, sizeof(mpmc_slot_t) * queue->capacity);
+    queue->slots = NULL;
+    return 0;
+}
+
+int mpmc_queue_try_push(mpmc_queue_t *queue, long double item) {
+    mpmc_slot_t *slot;
+    size_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    for (;;) {
+        slot = &queue->slots[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+        if (difference == 0) {
+            // the slot is free, try to claim the position; on failure position is reloaded with the current tail
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // the slot still holds an item from the previous lap, so the queue is full
+            return 0;
+        } else {
+            // another producer claimed this position, catch up with tail
+            position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+
+    slot->item = item;
+    if (queue->latency != NULL) {
+        slot->stamp = latency_recorder_now(queue->latency);
+    }
+
+    // publish the item to the consumer that claims this position
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    wait_parker_notify(&queue->not_empty, 1);
+    if (queue->events != NULL) {
+        event_notifier_signal(queue->events);
+    }
+    return 1;
+}
+
+int mpmc_queue_try_pop(mpmc_queue_t *queue, long double *item) {
+    mpmc_slot_t *slot;
+    size_t position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    for (;;) {
+        slot = &queue->slots[position & queue->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+
+        if (difference == 0) {
+            // the slot holds an item, try to claim the position; on failure position is reloaded with the current head
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // the producer for this position has not published yet, so the queue is empty
+            return 0;
+        } else {
+            // another consumer claimed this position, catch up with head
+            position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+
+    *item = slot->item;
+    if (queue->latency != NULL) {
+        latency_recorder_record(queue->latency, latency_recorder_elapsed(queue->latency, slot->stamp));
+    }
+
+    // free the slot for the producer that claims this position on the next lap
+    atomic_store_explicit(&slot->sequence, position + queue->capacity, memory_order_release);
+    wait_parker_notify(&queue->not_full, 1);
+    return 1;
+}
+
+/***
+ * Wait condition that appends the item of an item context once there is room
+ * @param context the item context
+ * @return 1 if the item was appended, 0 otherwise
+ */
+static int push_condition(void *context) {
+    item_context_t *push = (item_context_t *) context;
+    return mpmc_queue_try_push(push->queue, *push->item);
+}
+
+/***
+ * Wait condition that removes an item into an item context once there is one
+ * @param context the item context
+ * @return 1 if an item was removed, 0 otherwise
+ */
+static int pop_condition(void *context) {
+    item_context_t *pop = (item_context_t *) context;
+    return mpmc_queue_try_pop(pop->queue, pop->item);
+}
+
+void mpmc_queue_push(mpmc_queue_t *queue, long double item) {
+    item_context_t context = {queue, &item};
+
+    if (!mpmc_queue_try_push(queue, item)) {
+        wait_strategy_wait(&queue->not_full, &queue->producer_statistics, push_condition, &context);
+    }
+}
+
+long double mpmc_queue_pop(mpmc_queue_t *queue) {
+    long double item;
+    item_context_t context = {queue, &item};
+
+    if (!mpmc_queue_try_pop(queue, &item)) {
+        wait_strategy_wait(&queue->not_empty, &queue->consumer_statistics, pop_condition, &context);
+    }
+    return item;
+}
+
+int mpmc_queue_timed_push(mpmc_queue_t *queue, long double item, const struct timespec *deadline) {
+    item_context_t context = {queue, &item};
+
+    if (mpmc_queue_try_push(queue, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&queue->not_full, &queue->producer_statistics, push_condition, &context, deadline);
+}
+
+int mpmc_queue_timed_pop(mpmc_queue_t *queue, long double *item, const struct timespec *deadline) {
+    item_context_t context = {queue, item};
+
+    if (mpmc_queue_try_pop(queue, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&queue->not_empty, &queue->consumer_statistics, pop_condition, &context, deadline);
+}
@@ -0,0 +1,145 @@
+/***
+ * Lock-free multi-producer/multi-consumer bounded queue
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Every slot carries a sequence number that tells producers and consumers whose turn it is to use the slot.
+ * A producer at position p may write slot p when its sequence equals p and a consumer at position p may read
+ * it when its sequence equals p + 1. Producers and consumers claim positions with a compare-and-swap on tail
+ * and head respectively, so contention is limited to the threads on the same side of the queue.
+ *
+ * Positions never wrap back to zero, the slot for a position is found by masking it with the capacity, which is
+ * always a power of two.
+ *
+ * The blocking operations wait with the wait strategy, producers park on not_full and consumers park on not_empty.
+ *
+ * The read-only description of the storage, the producers' tail, the consumers' head and each parker live on
+ * separate cache lines, so a compare-and-swap by one side does not invalidate the line the other side reads.
+ *
+ * When latency recording is enabled every slot is stamped when it is published and the consumer records the time
+ * the item spent in the queue. The stamp fills the padding between the sequence and the item, so slots do not grow.
+ *
+ * The slots are mapped with the buffer memory policy, which chooses their page size and NUMA node.
+ */
+
+#ifndef BOUNDED_BUFFER_MPMC_QUEUE_H
+#define BOUNDED_BUFFER_MPMC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "cache_line.h"
+#include "event_notifier.h"
+#include "latency_histogram.h"
+#include "wait_strategy.h"
+
+/***
+ * A single slot of the queue
+ */
+typedef struct mpmc_slot {
+    atomic_size_t sequence;
+    uint64_t stamp;
+    long double item;
+} mpmc_slot_t;
+
+/***
+ * The queue, producers claim positions from tail and consumers claim positions from head
+ */
+typedef struct mpmc_queue {
+    CACHE_LINE_ALIGNED mpmc_slot_t *slots;
+    size_t capacity;
+    size_t mask;
+    latency_recorder_t *latency;
+    event_notifier_t *events;
+
+    CACHE_LINE_ALIGNED atomic_size_t tail;
+    wait_statistics_t producer_statistics;
+
+    CACHE_LINE_ALIGNED atomic_size_t head;
+    wait_statistics_t consumer_statistics;
+
+    CACHE_LINE_ALIGNED wait_parker_t not_full;
+    CACHE_LINE_ALIGNED wait_parker_t not_empty;
+} mpmc_queue_t;
+
+/***
+ * Initialize the queue and allocate storage for its slots
+ * @param queue the queue to initialize
+ * @param capacity the maximum number of items the queue can hold, rounded up to a power of two
+ * @return 0 on success, an error number otherwise
+ */
+int mpmc_queue_init(mpmc_queue_t *queue, size_t capacity);
+
+/***
+ * Stamp every item when it is published and record its latency when it is consumed, must be called before the
+ * queue is used
+ * @param queue the queue
+ * @param recorder the recorder the consumers record latencies into
+ * @return 0 on success, an error number otherwise
+ */
+int mpmc_queue_enable_latency(mpmc_queue_t *queue, latency_recorder_t *recorder);
+
+/***
+ * Write the eventfd of a notifier whenever the queue turns non-empty while the notifier is armed, so that the consumer
+ * can wait for items in epoll, must be called before the queue is used
+ * @param queue the queue
+ * @param notifier the notifier the consumer arms
+ */
+void mpmc_queue_enable_events(mpmc_queue_t *queue, event_notifier_t *notifier);
+
+/***
+ * Release the storage held by the queue
+ * @param queue the queue to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int mpmc_queue_destroy(mpmc_queue_t *queue);
+
+/***
+ * Append an item to the queue without waiting, safe to call from any number of threads
+ * @param queue the queue to append to
+ * @param item the item to append
+ * @return 1 if the item was appended, 0 if the queue was full
+ */
+int mpmc_queue_try_push(mpmc_queue_t *queue, long double item);
+
+/***
+ * Remove the oldest item from the queue without waiting, safe to call from any number of threads
+ * @param queue the queue to remove from
+ * @param item location where the removed item is stored
+ * @return 1 if an item was removed, 0 if the queue was empty
+ */
+int mpmc_queue_try_pop(mpmc_queue_t *queue, long double *item);
+
+/***
+ * Append an item to the queue, waiting while the queue is full
+ * @param queue the queue to append to
+ * @param item the item to append
+ */
+void mpmc_queue_push(mpmc_queue_t *queue, long double item);
+
+/***
+ * Remove the oldest item from the queue, waiting while the queue is empty
+ * @param queue the queue to remove from
+ * @return the removed item
+ */
+long double mpmc_queue_pop(mpmc_queue_t *queue);
+
+/***
+ * Append an item, waiting while the queue is full but no longer than until a deadline
+ * @param queue the queue to append to
+ * @param item the item to append
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if the item was appended, ETIMEDOUT if the deadline passed first
+ */
+int mpmc_queue_timed_push(mpmc_queue_t *queue, long double item, const struct timespec *deadline);
+
+/***
+ * Remove an item, waiting while the queue is empty but no longer than until a deadline
+ * @param queue the queue to remove from
+ * @param item location where the removed item is stored
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if an item was removed, ETIMEDOUT if the deadline passed first
+ */
+int mpmc_queue_timed_pop(mpmc_queue_t *queue, long double *item, const struct timespec *deadline);
+
+#endif //BOUNDED_BUFFER_MPMC_QUEUE_H
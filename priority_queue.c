@@ -0,0 +1,298 @@
+/***
+ * Multi-level priority queue with a lane per priority and a consumer-side scheduler
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "priority_queue.h"
+
+/***
+ * Context of a blocking push
+ */
+typedef struct push_context {
+    priority_queue_t *queue;
+    int lane;
+    long double *item;
+} push_context_t;
+
+/***
+ * Context of a blocking pop
+ */
+typedef struct pop_context {
+    priority_queue_t *queue;
+    priority_queue_cursor_t *cursor;
+    long double *item;
+} pop_context_t;
+
+int priority_queue_parse_weights(const char *text, unsigned int *weights, int max_count, int *count) {
+    const char *position = text;
+    char *end;
+    unsigned long weight;
+
+    *count = 0;
+    while (*position != '\0') {
+        weight = strtoul(position, &end, 10);
+        if (end == position || weight == 0 || weight > 1000000 || *count == max_count) {
+            return EINVAL;
+        }
+        weights[(*count)++] = (unsigned int) weight;
+
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            return EINVAL;
+        }
+        position = end;
+    }
+    return (*count > 0) ? 0 : EINVAL;
+}
+
+int priority_queue_init(priority_queue_t *queue, int lane_count, size_t lane_capacity, const unsigned int *weights,
+                        priority_queue_policy_t policy) {
+    priority_lane_t *lane;
+    int index, error_code;
+
+    if (lane_count < 1 || lane_count > MAX_PRIORITY_LANES || lane_capacity == 0) {
+        return EINVAL;
+    }
+
+    // every lane starts on a cache line of its own, which malloc does not guarantee
+    queue->lanes = (priority_lane_t *) aligned_alloc(CACHE_LINE_SIZE, sizeof(priority_lane_t) * lane_count);
+    if (queue->lanes == NULL) {
+        return ENOMEM;
+    }
+
+    for (index = 0; index < lane_count; index++) {
+        lane = &queue->lanes[index];
+        error_code = (weights[index] == 0) ? EINVAL : mpmc_queue_init(&lane->queue, lane_capacity);
+        if (error_code != 0) {
+            while (--index >= 0) {
+                mpmc_queue_destroy(&queue->lanes[index].queue);
+            }
+            free(queue->lanes);
+            queue->lanes = NULL;
+            return error_code;
+        }
+        lane->weight = weights[index];
+        lane->latency_enabled = 0;
+        atomic_init(&lane->items, 0);
+        atomic_init(&lane->depth_sum, 0);
+        atomic_init(&lane->max_depth, 0);
+    }
+
+    queue->lane_count = lane_count;
+    queue->policy = policy;
+    wait_statistics_init(&queue->consumer_statistics);
+    wait_parker_init(&queue->not_empty);
+    return 0;
+}
+
+int priority_queue_enable_latency(priority_queue_t *queue, latency_clock_t clock) {
+    priority_lane_t *lane;
+    int index, error_code;
+
+    for (index = 0; index < queue->lane_count; index++) {
+        lane = &queue->lanes[index];
+        error_code = latency_recorder_init(&lane->latency, clock);
+        if (error_code != 0) {
+            // leave the queue as it was, without a recorder in any lane
+            while (--index >= 0) {
+                lane = &queue->lanes[index];
+                mpmc_queue_enable_latency(&lane->queue, NULL);
+                latency_recorder_destroy(&lane->latency);
+                lane->latency_enabled = 0;
+            }
+            return error_code;
+        }
+        lane->latency_enabled = 1;
+        mpmc_queue_enable_latency(&lane->queue, &lane->latency);
+    }
+    return 0;
+}
+
+int priority_queue_destroy(priority_queue_t *queue) {
+    priority_lane_t *lane;
+    int index;
+
+    for (index = 0; index < queue->lane_count; index++) {
+        lane = &queue->lanes[index];
+        mpmc_queue_destroy(&lane->queue);
+        if (lane->latency_enabled) {
+            latency_recorder_destroy(&lane->latency);
+        }
+    }
+    free(queue->lanes);
+    queue->lanes = NULL;
+    return 0;
+}
+
+void priority_queue_cursor_init(priority_queue_t *queue, priority_queue_cursor_t *cursor) {
+    cursor->lane = 0;
+    cursor->credit = queue->lanes[0].weight;
+}
+
+int priority_queue_try_push(priority_queue_t *queue, int lane, long double item) {
+    if (!mpmc_queue_try_push(&queue->lanes[lane].queue, item)) {
+        return 0;
+    }
+
+    // consumers park on the queue rather than on a lane, since they do not know which lane will fill first
+    wait_parker_notify(&queue->not_empty, 1);
+    return 1;
+}
+
+/***
+ * Wait condition that appends the item of a push context once there is room
+ * @param context the push context
+ * @return 1 if the item was appended, 0 otherwise
+ */
+static int push_condition(void *context) {
+    push_context_t *push = (push_context_t *) context;
+    return priority_queue_try_push(push->queue, push->lane, *push->item);
+}
+
+void priority_queue_push(priority_queue_t *queue, int lane, long double item) {
+    push_context_t context = {queue, lane, &item};
+
+    if (!priority_queue_try_push(queue, lane, item)) {
+        wait_strategy_wait(&queue->lanes[lane].queue.not_full, &queue->lanes[lane].queue.producer_statistics,
+                           push_condition, &context);
+    }
+}
+
+/***
+ * Remove an item from a lane and sample the depth the lane had when the item was taken
+ * @param lane the lane
+ * @param item location where the removed item is stored
+ * @return 1 if an item was removed, 0 if the lane was empty
+ */
+static int pop_lane(priority_lane_t *lane, long double *item) {
+    size_t depth, deepest;
+
+    if (!mpmc_queue_try_pop(&lane->queue, item)) {
+        return 0;
+    }
+
+    // a racy read of both ends is enough for a sample, counting the item we just took
+    depth = atomic_load_explicit(&lane->queue.tail, memory_order_relaxed) -
+            atomic_load_explicit(&lane->queue.head, memory_order_relaxed) + 1;
+    if (depth > lane->queue.capacity) {
+        depth = lane->queue.capacity;
+    }
+    atomic_fetch_add_explicit(&lane->items, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&lane->depth_sum, depth, memory_order_relaxed);
+    deepest = atomic_load_explicit(&lane->max_depth, memory_order_relaxed);
+    while (depth > deepest) {
+        if (atomic_compare_exchange_weak_explicit(&lane->max_depth, &deepest, depth, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+            break;
+        }
+    }
+    return 1;
+}
+
+int priority_queue_try_pop(priority_queue_t *queue, priority_queue_cursor_t *cursor, long double *item) {
+    int lane, visited;
+
+    if (queue->policy == PRIORITY_QUEUE_STRICT) {
+        for (lane = 0; lane < queue->lane_count; lane++) {
+            if (pop_lane(&queue->lanes[lane], item)) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    // the lane of the cursor may have credit left, so one extra visit brings us back to it after every other lane
+    for (visited = 0; visited <= queue->lane_count; visited++) {
+        if (cursor->credit == 0) {
+            cursor->lane = (cursor->lane + 1 == queue->lane_count) ? 0 : cursor->lane + 1;
+            cursor->credit = queue->lanes[cursor->lane].weight;
+        }
+        if (pop_lane(&queue->lanes[cursor->lane], item)) {
+            cursor->credit--;
+            return 1;
+        }
+
+        // an empty lane gives its turn away
+        cursor->credit = 0;
+    }
+    return 0;
+}
+
+/***
+ * Wait condition that removes an item into a pop context once there is one
+ * @param context the pop context
+ * @return 1 if an item was removed, 0 otherwise
+ */
+static int pop_condition(void *context) {
+    pop_context_t *pop = (pop_context_t *) context;
+    return priority_queue_try_pop(pop->queue, pop->cursor, pop->item);
+}
+
+long double priority_queue_pop(priority_queue_t *queue, priority_queue_cursor_t *cursor) {
+    long double item;
+    pop_context_t context = {queue, cursor, &item};
+
+    if (!priority_queue_try_pop(queue, cursor, &item)) {
+        wait_strategy_wait(&queue->not_empty, &queue->consumer_statistics, pop_condition, &context);
+    }
+    return item;
+}
+
+int priority_queue_timed_push(priority_queue_t *queue, int lane, long double item, const struct timespec *deadline) {
+    push_context_t context = {queue, lane, &item};
+
+    if (priority_queue_try_push(queue, lane, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&queue->lanes[lane].queue.not_full, &queue->lanes[lane].queue.producer_statistics,
+                                    push_condition, &context, deadline);
+}
+
+int priority_queue_timed_pop(priority_queue_t *queue, priority_queue_cursor_t *cursor, long double *item,
+                             const struct timespec *deadline) {
+    pop_context_t context = {queue, cursor, item};
+
+    if (priority_queue_try_pop(queue, cursor, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&queue->not_empty, &queue->consumer_statistics, pop_condition, &context, deadline);
+}
+
+void priority_queue_producer_statistics(priority_queue_t *queue, wait_statistics_t *statistics) {
+    wait_statistics_t *lane_statistics;
+    int lane;
+
+    wait_statistics_init(statistics);
+    for (lane = 0; lane < queue->lane_count; lane++) {
+        lane_statistics = &queue->lanes[lane].queue.producer_statistics;
+        atomic_fetch_add(&statistics->spin, atomic_load(&lane_statistics->spin));
+        atomic_fetch_add(&statistics->yield, atomic_load(&lane_statistics->yield));
+        atomic_fetch_add(&statistics->park, atomic_load(&lane_statistics->park));
+        atomic_fetch_add(&statistics->timeout, atomic_load(&lane_statistics->timeout));
+    }
+}
+
+void priority_queue_print(priority_queue_t *queue) {
+    priority_lane_t *lane;
+    unsigned long long items;
+    char name[32];
+    int index;
+
+    for (index = 0; index < queue->lane_count; index++) {
+        lane = &queue->lanes[index];
+        items = atomic_load(&lane->items);
+        printf("Lane %d (weight %u) took %llu items, depth mean %.1f, max %zu\n", index, lane->weight, items,
+               (items > 0) ? (double) atomic_load(&lane->depth_sum) / (double) items : 0.0,
+               atomic_load(&lane->max_depth));
+        if (lane->latency_enabled) {
+            snprintf(name, sizeof(name), "Lane %d", index);
+            latency_recorder_print(name, &lane->latency);
+        }
+    }
+}
@@ -0,0 +1,193 @@
+/***
+ * Multi-level priority queue with a lane per priority and a consumer-side scheduler
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * In a single FIFO an urgent item waits behind every bulk item that was pushed before it, so its latency grows
+ * with the bulk load. The priority queue keeps a lock-free MPMC queue per priority level, lane 0 being the most
+ * urgent, and consumers pick the lane to take the next item from:
+ *
+ * - PRIORITY_QUEUE_STRICT always takes from the most urgent lane that holds an item, so an urgent item only ever
+ *   waits for the items of its own lane. Lower lanes starve for as long as a higher lane stays busy.
+ * - PRIORITY_QUEUE_WEIGHTED serves the lanes in turn and takes up to the weight of a lane from it before moving on,
+ *   so every lane gets a share of the consumers proportional to its weight while it has items, and a lane without
+ *   items gives its turn away at once.
+ *
+ * Every lane counts the items taken from it and samples its depth when an item is taken, and with latency
+ * recording enabled every lane records the time its items spent in it into a recorder of its own, so the classes
+ * can be compared directly.
+ *
+ * A producer that finds its lane full parks on the lane. A consumer that finds every lane empty parks on the
+ * queue, which every producer notifies after publishing an item.
+ */
+
+#ifndef BOUNDED_BUFFER_PRIORITY_QUEUE_H
+#define BOUNDED_BUFFER_PRIORITY_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "cache_line.h"
+#include "latency_histogram.h"
+#include "mpmc_queue.h"
+#include "wait_strategy.h"
+
+#define MAX_PRIORITY_LANES 8
+
+/***
+ * How consumers pick the lane to take the next item from
+ */
+typedef enum {
+    PRIORITY_QUEUE_STRICT,
+    PRIORITY_QUEUE_WEIGHTED
+} priority_queue_policy_t;
+
+/***
+ * A lane, the queue of one priority level, its weight and its metrics, which consumers update
+ */
+typedef struct priority_lane {
+    mpmc_queue_t queue;
+    unsigned int weight;
+    int latency_enabled;
+    latency_recorder_t latency;
+
+    CACHE_LINE_ALIGNED atomic_ullong items;
+    atomic_ullong depth_sum;
+    atomic_size_t max_depth;
+} priority_lane_t;
+
+/***
+ * The queue, the description of the lanes is read-only once initialized
+ */
+typedef struct priority_queue {
+    CACHE_LINE_ALIGNED priority_lane_t *lanes;
+    int lane_count;
+    priority_queue_policy_t policy;
+
+    CACHE_LINE_ALIGNED wait_statistics_t consumer_statistics;
+
+    CACHE_LINE_ALIGNED wait_parker_t not_empty;
+} priority_queue_t;
+
+/***
+ * The position of a consumer in the weighted round robin, each consumer keeps one of its own
+ */
+typedef struct priority_queue_cursor {
+    int lane;
+    unsigned int credit;
+} priority_queue_cursor_t;
+
+/***
+ * Parse a comma separated list of lane weights, most urgent lane first
+ * @param text the list, e.g. 4,1
+ * @param weights location where the weights are stored
+ * @param max_count the number of weights weights can hold
+ * @param count location where the number of weights is stored
+ * @return 0 on success, EINVAL if the list is malformed, has a weight of 0 or more than max_count weights
+ */
+int priority_queue_parse_weights(const char *text, unsigned int *weights, int max_count, int *count);
+
+/***
+ * Initialize the queue and allocate its lanes
+ * @param queue the queue to initialize
+ * @param lane_count the number of priority levels, at most MAX_PRIORITY_LANES
+ * @param lane_capacity the maximum number of items each lane can hold, rounded up to a power of two
+ * @param weights the weight of every lane, most urgent lane first
+ * @param policy how consumers pick the lane to take the next item from
+ * @return 0 on success, an error number otherwise
+ */
+int priority_queue_init(priority_queue_t *queue, int lane_count, size_t lane_capacity, const unsigned int *weights,
+                        priority_queue_policy_t policy);
+
+/***
+ * Record the latency of every item in a recorder per lane, must be called before the queue is used
+ * @param queue the queue
+ * @param clock the clock to measure latencies with
+ * @return 0 on success, an error number otherwise
+ */
+int priority_queue_enable_latency(priority_queue_t *queue, latency_clock_t clock);
+
+/***
+ * Release the storage held by the queue
+ * @param queue the queue to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int priority_queue_destroy(priority_queue_t *queue);
+
+/***
+ * Start a consumer at the most urgent lane with the full weight of the lane
+ * @param queue the queue
+ * @param cursor the cursor to initialize
+ */
+void priority_queue_cursor_init(priority_queue_t *queue, priority_queue_cursor_t *cursor);
+
+/***
+ * Append an item to a lane without waiting
+ * @param queue the queue to append to
+ * @param lane the priority level of the item, 0 being the most urgent
+ * @param item the item to append
+ * @return 1 if the item was appended, 0 if the lane was full
+ */
+int priority_queue_try_push(priority_queue_t *queue, int lane, long double item);
+
+/***
+ * Append an item to a lane, waiting while the lane is full
+ * @param queue the queue to append to
+ * @param lane the priority level of the item, 0 being the most urgent
+ * @param item the item to append
+ */
+void priority_queue_push(priority_queue_t *queue, int lane, long double item);
+
+/***
+ * Remove an item from the lane the policy picks without waiting
+ * @param queue the queue to remove from
+ * @param cursor the cursor of the consumer
+ * @param item location where the removed item is stored
+ * @return 1 if an item was removed, 0 if every lane was empty
+ */
+int priority_queue_try_pop(priority_queue_t *queue, priority_queue_cursor_t *cursor, long double *item);
+
+/***
+ * Remove an item from the lane the policy picks, waiting while every lane is empty
+ * @param queue the queue to remove from
+ * @param cursor the cursor of the consumer
+ * @return the removed item
+ */
+long double priority_queue_pop(priority_queue_t *queue, priority_queue_cursor_t *cursor);
+
+/***
+ * Append an item to a lane, waiting while the lane is full but no longer than until a deadline
+ * @param queue the queue to append to
+ * @param lane the priority level of the item, 0 being the most urgent
+ * @param item the item to append
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if the item was appended, ETIMEDOUT if the deadline passed first
+ */
+int priority_queue_timed_push(priority_queue_t *queue, int lane, long double item, const struct timespec *deadline);
+
+/***
+ * Remove an item from the lane the policy picks, waiting while every lane is empty but no longer than
+ * until a deadline
+ * @param queue the queue to remove from
+ * @param cursor the cursor of the consumer
+ * @param item location where the removed item is stored
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if an item was removed, ETIMEDOUT if the deadline passed first
+ */
+int priority_queue_timed_pop(priority_queue_t *queue, priority_queue_cursor_t *cursor, long double *item,
+                             const struct timespec *deadline);
+
+/***
+ * Sum the wait statistics of the producers of every lane
+ * @param queue the queue
+ * @param statistics location where the sums are stored
+ */
+void priority_queue_producer_statistics(priority_queue_t *queue, wait_statistics_t *statistics);
+
+/***
+ * Print the number of items, the mean and maximum depth and, when recorded, the latency of every lane
+ * @param queue the queue
+ */
+void priority_queue_print(priority_queue_t *queue);
+
+#endif //BOUNDED_BUFFER_PRIORITY_QUEUE_H
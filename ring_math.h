@@ -0,0 +1,25 @@
+/***
+ * Index arithmetic shared by the ring buffers
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#ifndef BOUNDED_BUFFER_RING_MATH_H
+#define BOUNDED_BUFFER_RING_MATH_H
+
+#include <stddef.h>
+
+/***
+ * Round a capacity up to the next power of two so that slot indices can be computed with a mask
+ * @param capacity the requested capacity, must be greater than 0
+ * @return the smallest power of two that is greater than or equal to capacity
+ */
+static inline size_t round_up_power_of_two(size_t capacity) {
+    size_t power = 1;
+    while (power < capacity) {
+        power <<= 1;
+    }
+    return power;
+}
+
+#endif //BOUNDED_BUFFER_RING_MATH_H
@@ -0,0 +1,202 @@
+/***
+ * Sharded multi-producer/multi-consumer queue with a lane per producer
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "sharded_queue.h"
+
+/***
+ * Context of a blocking push
+ */
+typedef struct push_context {
+    sharded_queue_t *queue;
+    int lane;
+    long double *item;
+} push_context_t;
+
+/***
+ * Context of a blocking pop
+ */
+typedef struct pop_context {
+    sharded_queue_t *queue;
+    sharded_queue_cursor_t *cursor;
+    long double *item;
+} pop_context_t;
+
+int sharded_queue_init(sharded_queue_t *queue, int lane_count, size_t lane_capacity, int consumer_count,
+                       sharded_queue_policy_t policy) {
+    int lane, error_code;
+
+    if (lane_count < 1 || lane_capacity == 0 || consumer_count < 1) {
+        return EINVAL;
+    }
+
+    // every lane starts on a cache line of its own, which malloc does not guarantee
+    queue->lanes = (sharded_lane_t *) aligned_alloc(CACHE_LINE_SIZE, sizeof(sharded_lane_t) * lane_count);
+    if (queue->lanes == NULL) {
+        return ENOMEM;
+    }
+
+    for (lane = 0; lane < lane_count; lane++) {
+        error_code = spsc_ring_init(&queue->lanes[lane].ring, lane_capacity);
+        if (error_code != 0) {
+            while (--lane >= 0) {
+                spsc_ring_destroy(&queue->lanes[lane].ring);
+            }
+            free(queue->lanes);
+            queue->lanes = NULL;
+            return error_code;
+        }
+        atomic_init(&queue->lanes[lane].consumer_lock, 0);
+    }
+
+    queue->lane_count = lane_count;
+    queue->shared_lanes = consumer_count > 1;
+    queue->policy = policy;
+    wait_statistics_init(&queue->consumer_statistics);
+    wait_parker_init(&queue->not_empty);
+    return 0;
+}
+
+int sharded_queue_enable_latency(sharded_queue_t *queue, latency_recorder_t *recorder) {
+    int lane, error_code;
+
+    for (lane = 0; lane < queue->lane_count; lane++) {
+        error_code = spsc_ring_enable_latency(&queue->lanes[lane].ring, recorder);
+        if (error_code != 0) {
+            return error_code;
+        }
+    }
+    return 0;
+}
+
+int sharded_queue_destroy(sharded_queue_t *queue) {
+    int lane;
+
+    for (lane = 0; lane < queue->lane_count; lane++) {
+        spsc_ring_destroy(&queue->lanes[lane].ring);
+    }
+    free(queue->lanes);
+    queue->lanes = NULL;
+    return 0;
+}
+
+void sharded_queue_cursor_init(sharded_queue_t *queue, sharded_queue_cursor_t *cursor, int consumer_id) {
+    cursor->lane = consumer_id % queue->lane_count;
+}
+
+int sharded_queue_try_push(sharded_queue_t *queue, int lane, long double item) {
+    if (!spsc_ring_try_push(&queue->lanes[lane].ring, item)) {
+        return 0;
+    }
+
+    // consumers park on the queue rather than on a lane, since they do not know which lane will fill first
+    wait_parker_notify(&queue->not_empty, 1);
+    return 1;
+}
+
+/***
+ * Wait condition that appends the item of a push context once there is room
+ * @param context the push context
+ * @return 1 if the item was appended, 0 otherwise
+ */
+static int push_condition(void *context) {
+    push_context_t *push = (push_context_t *) context;
+    return sharded_queue_try_push(push->queue, push->lane, *push->item);
+}
+
+void sharded_queue_push(sharded_queue_t *queue, int lane, long double item) {
+    push_context_t context = {queue, lane, &item};
+
+    if (!sharded_queue_try_push(queue, lane, item)) {
+        wait_strategy_wait(&queue->lanes[lane].ring.not_full, &queue->lanes[lane].ring.producer_statistics,
+                           push_condition, &context);
+    }
+}
+
+int sharded_queue_try_pop(sharded_queue_t *queue, sharded_queue_cursor_t *cursor, long double *item) {
+    sharded_lane_t *current;
+    int visited, lane = cursor->lane, found = 0;
+
+    for (visited = 0; visited < queue->lane_count && !found; visited++) {
+        current = &queue->lanes[lane];
+
+        // a lane held by another consumer is skipped, testing the lock first keeps its line shared
+        if (!queue->shared_lanes) {
+            found = spsc_ring_try_pop(&current->ring, item);
+        } else if (atomic_load_explicit(&current->consumer_lock, memory_order_relaxed) == 0 &&
+                   atomic_exchange_explicit(&current->consumer_lock, 1, memory_order_acquire) == 0) {
+            found = spsc_ring_try_pop(&current->ring, item);
+            atomic_store_explicit(&current->consumer_lock, 0, memory_order_release);
+            if (found) {
+                wait_parker_notify(&queue->not_empty, 1);
+            }
+        }
+
+        // drain stays on a lane as long as it yields items, round robin moves on after every item
+        if (!found || queue->policy == SHARDED_QUEUE_ROUND_ROBIN) {
+            lane = (lane + 1 == queue->lane_count) ? 0 : lane + 1;
+        }
+    }
+
+    cursor->lane = lane;
+    return found;
+}
+
+/***
+ * Wait condition that removes an item into a pop context once there is one
+ * @param context the pop context
+ * @return 1 if an item was removed, 0 otherwise
+ */
+static int pop_condition(void *context) {
+    pop_context_t *pop = (pop_context_t *) context;
+    return sharded_queue_try_pop(pop->queue, pop->cursor, pop->item);
+}
+
+long double sharded_queue_pop(sharded_queue_t *queue, sharded_queue_cursor_t *cursor) {
+    long double item;
+    pop_context_t context = {queue, cursor, &item};
+
+    if (!sharded_queue_try_pop(queue, cursor, &item)) {
+        wait_strategy_wait(&queue->not_empty, &queue->consumer_statistics, pop_condition, &context);
+    }
+    return item;
+}
+
+int sharded_queue_timed_push(sharded_queue_t *queue, int lane, long double item, const struct timespec *deadline) {
+    push_context_t context = {queue, lane, &item};
+
+    if (sharded_queue_try_push(queue, lane, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&queue->lanes[lane].ring.not_full, &queue->lanes[lane].ring.producer_statistics,
+                                    push_condition, &context, deadline);
+}
+
+int sharded_queue_timed_pop(sharded_queue_t *queue, sharded_queue_cursor_t *cursor, long double *item,
+                            const struct timespec *deadline) {
+    pop_context_t context = {queue, cursor, item};
+
+    if (sharded_queue_try_pop(queue, cursor, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&queue->not_empty, &queue->consumer_statistics, pop_condition, &context, deadline);
+}
+
+void sharded_queue_producer_statistics(sharded_queue_t *queue, wait_statistics_t *statistics) {
+    wait_statistics_t *lane_statistics;
+    int lane;
+
+    wait_statistics_init(statistics);
+    for (lane = 0; lane < queue->lane_count; lane++) {
+        lane_statistics = &queue->lanes[lane].ring.producer_statistics;
+        atomic_fetch_add(&statistics->spin, atomic_load(&lane_statistics->spin));
+        atomic_fetch_add(&statistics->yield, atomic_load(&lane_statistics->yield));
+        atomic_fetch_add(&statistics->park, atomic_load(&lane_statistics->park));
+        atomic_fetch_add(&statistics->timeout, atomic_load(&lane_statistics->timeout));
+    }
+}
@@ -0,0 +1,170 @@
+/***
+ * Sharded multi-producer/multi-consumer queue with a lane per producer
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * A single ring is one contention point however it is synchronized: every producer writes the same tail and every
+ * consumer the same head. The sharded queue gives every producer a lane of its own, a single-producer ring, so
+ * producers never touch each other's lines and throughput grows with the number of producers. Items of one
+ * producer leave its lane in the order they entered it.
+ *
+ * Consumers visit the lanes in turn. With SHARDED_QUEUE_ROUND_ROBIN a consumer moves on to the next lane after
+ * every item, which serves all producers fairly; with SHARDED_QUEUE_DRAIN it stays on a lane until the lane is
+ * empty, which keeps the lane's lines in its cache for as long as the producer keeps up. When the queue has more
+ * than one consumer a consumer takes a lane with a try-lock for each item and skips lanes another consumer holds,
+ * so consumers spread over the lanes instead of queueing on one; a single consumer takes no lock at all. A consumer
+ * that took an item from a shared lane notifies the queue, since a consumer that skipped the lane while it was held
+ * may have parked with the item still in it.
+ *
+ * A producer that finds its lane full parks on the lane. A consumer that finds every lane empty parks on the
+ * queue, which every producer notifies after publishing an item.
+ */
+
+#ifndef BOUNDED_BUFFER_SHARDED_QUEUE_H
+#define BOUNDED_BUFFER_SHARDED_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "cache_line.h"
+#include "latency_histogram.h"
+#include "spsc_ring.h"
+#include "wait_strategy.h"
+
+/***
+ * How consumers move between lanes
+ */
+typedef enum {
+    SHARDED_QUEUE_ROUND_ROBIN,
+    SHARDED_QUEUE_DRAIN
+} sharded_queue_policy_t;
+
+/***
+ * A lane, the ring of one producer and the lock its consumers take, which is 1 while a consumer holds the lane
+ */
+typedef struct sharded_lane {
+    spsc_ring_t ring;
+    CACHE_LINE_ALIGNED atomic_int consumer_lock;
+} sharded_lane_t;
+
+/***
+ * The queue, the description of the lanes is read-only once initialized
+ */
+typedef struct sharded_queue {
+    CACHE_LINE_ALIGNED sharded_lane_t *lanes;
+    int lane_count;
+    int shared_lanes;
+    sharded_queue_policy_t policy;
+
+    CACHE_LINE_ALIGNED wait_statistics_t consumer_statistics;
+
+    CACHE_LINE_ALIGNED wait_parker_t not_empty;
+} sharded_queue_t;
+
+/***
+ * The position of a consumer, each consumer keeps one of its own
+ */
+typedef struct sharded_queue_cursor {
+    int lane;
+} sharded_queue_cursor_t;
+
+/***
+ * Initialize the queue and allocate its lanes
+ * @param queue the queue to initialize
+ * @param lane_count the number of lanes, one per producer
+ * @param lane_capacity the maximum number of items each lane can hold, storage is rounded up to a power of two
+ * @param consumer_count the number of consumers that will pop from the queue
+ * @param policy how consumers move between lanes
+ * @return 0 on success, an error number otherwise
+ */
+int sharded_queue_init(sharded_queue_t *queue, int lane_count, size_t lane_capacity, int consumer_count,
+                       sharded_queue_policy_t policy);
+
+/***
+ * Record the latency of every item in each lane, must be called before the queue is used
+ * @param queue the queue
+ * @param recorder the recorder the consumers record latencies into
+ * @return 0 on success, an error number otherwise
+ */
+int sharded_queue_enable_latency(sharded_queue_t *queue, latency_recorder_t *recorder);
+
+/***
+ * Release the storage held by the queue
+ * @param queue the queue to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int sharded_queue_destroy(sharded_queue_t *queue);
+
+/***
+ * Start a consumer at a lane of its own, so that consumers do not all start at the first lane
+ * @param queue the queue
+ * @param cursor the cursor to initialize
+ * @param consumer_id the index of the consumer
+ */
+void sharded_queue_cursor_init(sharded_queue_t *queue, sharded_queue_cursor_t *cursor, int consumer_id);
+
+/***
+ * Append an item to a lane without waiting, must only be called from the producer that owns the lane
+ * @param queue the queue to append to
+ * @param lane the lane of the producer
+ * @param item the item to append
+ * @return 1 if the item was appended, 0 if the lane was full
+ */
+int sharded_queue_try_push(sharded_queue_t *queue, int lane, long double item);
+
+/***
+ * Append an item to a lane, waiting while the lane is full, must only be called from the producer that owns the
+ * lane
+ * @param queue the queue to append to
+ * @param lane the lane of the producer
+ * @param item the item to append
+ */
+void sharded_queue_push(sharded_queue_t *queue, int lane, long double item);
+
+/***
+ * Remove an item from the lane the policy picks without waiting
+ * @param queue the queue to remove from
+ * @param cursor the cursor of the consumer
+ * @param item location where the removed item is stored
+ * @return 1 if an item was removed, 0 if every lane was empty or held by another consumer
+ */
+int sharded_queue_try_pop(sharded_queue_t *queue, sharded_queue_cursor_t *cursor, long double *item);
+
+/***
+ * Remove an item from the lane the policy picks, waiting while every lane is empty
+ * @param queue the queue to remove from
+ * @param cursor the cursor of the consumer
+ * @return the removed item
+ */
+long double sharded_queue_pop(sharded_queue_t *queue, sharded_queue_cursor_t *cursor);
+
+/***
+ * Append an item to a lane, waiting while the lane is full but no longer than until a deadline
+ * @param queue the queue to append to
+ * @param lane the lane of the producer
+ * @param item the item to append
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if the item was appended, ETIMEDOUT if the deadline passed first
+ */
+int sharded_queue_timed_push(sharded_queue_t *queue, int lane, long double item, const struct timespec *deadline);
+
+/***
+ * Remove an item from the lane the policy picks, waiting while every lane is empty but no longer than
+ * until a deadline
+ * @param queue the queue to remove from
+ * @param cursor the cursor of the consumer
+ * @param item location where the removed item is stored
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if an item was removed, ETIMEDOUT if the deadline passed first
+ */
+int sharded_queue_timed_pop(sharded_queue_t *queue, sharded_queue_cursor_t *cursor, long double *item,
+                            const struct timespec *deadline);
+
+/***
+ * Sum the wait statistics of the producers of every lane
+ * @param queue the queue
+ * @param statistics location where the sums are stored
+ */
+void sharded_queue_producer_statistics(sharded_queue_t *queue, wait_statistics_t *statistics);
+
+#endif //BOUNDED_BUFFER_SHARDED_QUEUE_H
@@ -0,0 +1,241 @@
+/***
+ * Lock-free single-producer/single-consumer ring buffer in shared memory
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ring_math.h"
+#include "shm_ring.h"
+
+/***
+ * Context of a blocking operation
+ */
+typedef struct item_context {
+    shm_ring_t *ring;
+    long double *item;
+} item_context_t;
+
+/***
+ * Get the size of the shared memory object of a ring
+ * @param slot_count the number of slots, a power of two
+ * @return the size in bytes
+ */
+static size_t object_size(size_t slot_count) {
+    // the control block is a whole number of cache lines, so the slots start on a line of their own
+    return sizeof(shm_ring_control_t) + sizeof(long double) * slot_count;
+}
+
+/***
+ * Map a shared memory object
+ * @param ring the mapping to initialize
+ * @param fd the file descriptor of the object
+ * @param size the size of the object
+ * @return 0 on success, an error number otherwise
+ */
+static int map(shm_ring_t *ring, int fd, size_t size) {
+    void *address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        return errno;
+    }
+
+    ring->control = (shm_ring_control_t *) address;
+    ring->slots = (long double *) ((char *) address + sizeof(shm_ring_control_t));
+    ring->size = size;
+    return 0;
+}
+
+int shm_ring_create(shm_ring_t *ring, const char *name, size_t capacity) {
+    shm_ring_control_t *control;
+    size_t slot_count;
+    int fd, error_code;
+
+    if (capacity == 0) {
+        return EINVAL;
+    }
+    slot_count = round_up_power_of_two(capacity);
+
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return errno;
+    }
+
+    // a new object is zero filled, so the magic number stays clear until the ring is ready
+    error_code = (ftruncate(fd, (off_t) object_size(slot_count)) == 0) ? map(ring, fd, object_size(slot_count))
+                                                                         : errno;
+    close(fd);
+    if (error_code != 0) {
+        shm_unlink(name);
+        return error_code;
+    }
+
+    control = ring->control;
+    control->capacity = capacity;
+    control->mask = slot_count - 1;
+    atomic_init(&control->head, 0);
+    atomic_init(&control->tail, 0);
+    control->cached_head = 0;
+    control->cached_tail = 0;
+    wait_parker_init_shared(&control->not_full);
+    wait_parker_init_shared(&control->not_empty);
+    wait_statistics_init(&control->producer_statistics);
+    wait_statistics_init(&control->consumer_statistics);
+
+    // publish the initialized control block to processes that open the ring
+    atomic_store_explicit(&control->magic, SHM_RING_MAGIC, memory_order_release);
+    return 0;
+}
+
+int shm_ring_open(shm_ring_t *ring, const char *name) {
+    struct stat status;
+    int fd, error_code;
+
+    fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return errno;
+    }
+
+    // the creator may not have sized the object yet
+    if (fstat(fd, &status) != 0) {
+        error_code = errno;
+    } else if ((size_t) status.st_size < sizeof(shm_ring_control_t)) {
+        error_code = EAGAIN;
+    } else {
+        error_code = map(ring, fd, (size_t) status.st_size);
+    }
+    close(fd);
+    if (error_code != 0) {
+        return error_code;
+    }
+
+    // acquire pairs with the release in shm_ring_create, so the rest of the control block is visible
+    if (atomic_load_explicit(&ring->control->magic, memory_order_acquire) != SHM_RING_MAGIC) {
+        shm_ring_close(ring);
+        return EAGAIN;
+    }
+    if (ring->size != object_size(ring->control->mask + 1)) {
+        shm_ring_close(ring);
+        return EINVAL;
+    }
+    return 0;
+}
+
+int shm_ring_close(shm_ring_t *ring) {
+    if (munmap(ring->control, ring->size) != 0) {
+        return errno;
+    }
+    ring->control = NULL;
+    ring->slots = NULL;
+    return 0;
+}
+
+int shm_ring_unlink(const char *name) {
+    return (shm_unlink(name) == 0) ? 0 : errno;
+}
+
+int shm_ring_try_push(shm_ring_t *ring, long double item) {
+    shm_ring_control_t *control = ring->control;
+
+    // only the producer writes tail, so a relaxed load of our own index is enough
+    size_t tail = atomic_load_explicit(&control->tail, memory_order_relaxed);
+
+    // only look at the consumer's line when our copy of head says the ring is full
+    if (tail - control->cached_head == control->capacity) {
+        control->cached_head = atomic_load_explicit(&control->head, memory_order_acquire);
+        if (tail - control->cached_head == control->capacity) {
+            return 0;
+        }
+    }
+
+    ring->slots[tail & control->mask] = item;
+
+    // publish the item to the consumer
+    atomic_store_explicit(&control->tail, tail + 1, memory_order_release);
+    wait_parker_notify(&control->not_empty, 1);
+    return 1;
+}
+
+int shm_ring_try_pop(shm_ring_t *ring, long double *item) {
+    shm_ring_control_t *control = ring->control;
+
+    // only the consumer writes head, so a relaxed load of our own index is enough
+    size_t head = atomic_load_explicit(&control->head, memory_order_relaxed);
+
+    // only look at the producer's line when our copy of tail says the ring is empty
+    if (head == control->cached_tail) {
+        control->cached_tail = atomic_load_explicit(&control->tail, memory_order_acquire);
+        if (head == control->cached_tail) {
+            return 0;
+        }
+    }
+
+    *item = ring->slots[head & control->mask];
+
+    // hand the slot back to the producer
+    atomic_store_explicit(&control->head, head + 1, memory_order_release);
+    wait_parker_notify(&control->not_full, 1);
+    return 1;
+}
+
+/***
+ * Wait condition that appends the item of an item context once there is room
+ * @param context the item context
+ * @return 1 if the item was appended, 0 otherwise
+ */
+static int push_condition(void *context) {
+    item_context_t *push = (item_context_t *) context;
+    return shm_ring_try_push(push->ring, *push->item);
+}
+
+/***
+ * Wait condition that removes an item into an item context once there is one
+ * @param context the item context
+ * @return 1 if an item was removed, 0 otherwise
+ */
+static int pop_condition(void *context) {
+    item_context_t *pop = (item_context_t *) context;
+    return shm_ring_try_pop(pop->ring, pop->item);
+}
+
+void shm_ring_push(shm_ring_t *ring, long double item) {
+    item_context_t context = {ring, &item};
+
+    if (!shm_ring_try_push(ring, item)) {
+        wait_strategy_wait(&ring->control->not_full, &ring->control->producer_statistics, push_condition, &context);
+    }
+}
+
+long double shm_ring_pop(shm_ring_t *ring) {
+    long double item;
+    item_context_t context = {ring, &item};
+
+    if (!shm_ring_try_pop(ring, &item)) {
+        wait_strategy_wait(&ring->control->not_empty, &ring->control->consumer_statistics, pop_condition, &context);
+    }
+    return item;
+}
+
+int shm_ring_timed_push(shm_ring_t *ring, long double item, const struct timespec *deadline) {
+    item_context_t context = {ring, &item};
+
+    if (shm_ring_try_push(ring, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&ring->control->not_full, &ring->control->producer_statistics, push_condition,
+                                    &context, deadline);
+}
+
+int shm_ring_timed_pop(shm_ring_t *ring, long double *item, const struct timespec *deadline) {
+    item_context_t context = {ring, item};
+
+    if (shm_ring_try_pop(ring, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&ring->control->not_empty, &ring->control->consumer_statistics, pop_condition,
+                                    &context, deadline);
+}
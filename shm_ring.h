@@ -0,0 +1,140 @@
+/***
+ * Lock-free single-producer/single-consumer ring buffer in shared memory
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * The same ring as spsc_ring_t, placed in a POSIX shared memory object so that a producer and a consumer in
+ * different processes on the same host exchange items through memory, without a socket, a pipe or a system call
+ * on the fast path. The control block is at the start of the object and the slots follow it; every process maps
+ * the object at an address of its own, so the control block holds no pointers and each process keeps its own
+ * pointer to the slots.
+ *
+ * The parkers use process-shared futexes, so a producer or consumer that runs out of slots or items parks in the
+ * kernel until the other process notifies it, exactly like the threads of a single process do.
+ *
+ * One process creates the ring, which sizes and initializes the object and then publishes a magic number; the
+ * other opens it by name and is refused with EAGAIN until the magic number is there. Either process may unlink
+ * the name once both have mapped the ring.
+ */
+
+#ifndef BOUNDED_BUFFER_SHM_RING_H
+#define BOUNDED_BUFFER_SHM_RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "cache_line.h"
+#include "wait_strategy.h"
+
+#define SHM_RING_MAGIC 0x42425348u
+
+/***
+ * The control block at the start of the shared memory object, the producer owns tail and cached_head and the
+ * consumer owns head and cached_tail
+ */
+typedef struct shm_ring_control {
+    CACHE_LINE_ALIGNED atomic_uint magic;
+    size_t capacity;
+    size_t mask;
+
+    CACHE_LINE_ALIGNED atomic_size_t tail;
+    size_t cached_head;
+    wait_statistics_t producer_statistics;
+
+    CACHE_LINE_ALIGNED atomic_size_t head;
+    size_t cached_tail;
+    wait_statistics_t consumer_statistics;
+
+    CACHE_LINE_ALIGNED wait_parker_t not_full;
+    CACHE_LINE_ALIGNED wait_parker_t not_empty;
+} shm_ring_control_t;
+
+/***
+ * A process's mapping of a ring
+ */
+typedef struct shm_ring {
+    shm_ring_control_t *control;
+    long double *slots;
+    size_t size;
+} shm_ring_t;
+
+/***
+ * Create a shared memory object for a ring, map it and initialize the ring
+ * @param ring the mapping to initialize
+ * @param name the name of the shared memory object, a slash followed by up to 254 characters, must not exist
+ * @param capacity the maximum number of items the ring can hold, storage is rounded up to a power of two
+ * @return 0 on success, an error number otherwise
+ */
+int shm_ring_create(shm_ring_t *ring, const char *name, size_t capacity);
+
+/***
+ * Map a ring created by another process
+ * @param ring the mapping to initialize
+ * @param name the name of the shared memory object
+ * @return 0 on success, EAGAIN if the creator has not initialized the ring yet, another error number otherwise
+ */
+int shm_ring_open(shm_ring_t *ring, const char *name);
+
+/***
+ * Unmap a ring, the ring lives on as long as another process maps it or its name exists
+ * @param ring the mapping to release
+ * @return 0 on success, an error number otherwise
+ */
+int shm_ring_close(shm_ring_t *ring);
+
+/***
+ * Remove the name of a ring, processes that mapped it keep using it
+ * @param name the name of the shared memory object
+ * @return 0 on success, an error number otherwise
+ */
+int shm_ring_unlink(const char *name);
+
+/***
+ * Append an item to the ring without waiting, must only be called from the producer
+ * @param ring the ring to append to
+ * @param item the item to append
+ * @return 1 if the item was appended, 0 if the ring was full
+ */
+int shm_ring_try_push(shm_ring_t *ring, long double item);
+
+/***
+ * Remove the oldest item from the ring without waiting, must only be called from the consumer
+ * @param ring the ring to remove from
+ * @param item location where the removed item is stored
+ * @return 1 if an item was removed, 0 if the ring was empty
+ */
+int shm_ring_try_pop(shm_ring_t *ring, long double *item);
+
+/***
+ * Append an item to the ring, waiting while the ring is full
+ * @param ring the ring to append to
+ * @param item the item to append
+ */
+void shm_ring_push(shm_ring_t *ring, long double item);
+
+/***
+ * Remove the oldest item from the ring, waiting while the ring is empty
+ * @param ring the ring to remove from
+ * @return the removed item
+ */
+long double shm_ring_pop(shm_ring_t *ring);
+
+/***
+ * Append an item, waiting while the ring is full but no longer than until a deadline
+ * @param ring the ring to append to
+ * @param item the item to append
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if the item was appended, ETIMEDOUT if the deadline passed first
+ */
+int shm_ring_timed_push(shm_ring_t *ring, long double item, const struct timespec *deadline);
+
+/***
+ * Remove an item, waiting while the ring is empty but no longer than until a deadline
+ * @param ring the ring to remove from
+ * @param item location where the removed item is stored
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if an item was removed, ETIMEDOUT if the deadline passed first
+ */
+int shm_ring_timed_pop(shm_ring_t *ring, long double *item, const struct timespec *deadline);
+
+#endif //BOUNDED_BUFFER_SHM_RING_H
@@ -0,0 +1,360 @@
+/***
+ * Lock-free single-producer/single-consumer ring buffer
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer_memory.h"
+#include "ring_math.h"
+#include "spsc_ring.h"
+
+/***
+ * Context of a blocking single item operation
+ */
+typedef struct item_context {
+    spsc_ring_t *ring;
+    long double *item;
+} item_context_t;
+
+/***
+ * Context of a blocking batch operation, done counts the items moved so far
+ */
+typedef struct batch_context {
+    spsc_ring_t *ring;
+    long double *items;
+    size_t count;
+    size_t done;
+} batch_context_t;
+
+int spsc_ring_init(spsc_ring_t *ring, size_t capacity) {
+    size_t size;
+    int error_code;
+
+    if (capacity == 0) {
+        return EINVAL;
+    }
+
+    size = round_up_power_of_two(capacity);
+    error_code = buffer_memory_allocate((void **) &ring->slots, sizeof(long double) * size);
+    if (error_code != 0) {
+        return error_code;
+    }
+
+    ring->capacity = capacity;
+    ring->mask = size - 1;
+    ring->stamps = NULL;
+    ring->latency = NULL;
+    ring->events = NULL;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->cached_head = 0;
+    ring->cached_tail = 0;
+    wait_parker_init(&ring->not_full);
+    wait_parker_init(&ring->not_empty);
+    wait_statistics_init(&ring->producer_statistics);
+    wait_statistics_init(&ring->consumer_statistics);
+    return 0;
+}
+
+int spsc_ring_enable_latency(spsc_ring_t *ring, latency_recorder_t *recorder) {
+    ring->stamps = (uint64_t *) malloc(sizeof(uint64_t) * (ring->mask + 1));
+    if (ring->stamps == NULL) {
+        return ENOMEM;
+    }
+
+    ring->latency = recorder;
+    return 0;
+}
+
+void spsc_ring_enable_events(spsc_ring_t *ring, event_notifier_t *notifier) {
+    ring->events = notifier;
+}
+
+int spsc_ring_destroy(spsc_ring_t *ring) {
+    buffer_memory_free(ring->slots, sizeof(long double) * (ring->mask + 1));
+    free(ring->stamps);
+    ring->slots = NULL;
+    ring->stamps = NULL;
+    return 0;
+}
+
+int spsc_ring_try_push(spsc_ring_t *ring, long double item) {
+    // only the producer writes tail, so a relaxed load of our own index is enough
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    // only look at the consumer's line when our copy of head says the ring is full, acquire pairs with the
+    // release in try_pop so the consumer is done with the slot before we overwrite it
+    if (tail - ring->cached_head == ring->capacity) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->cached_head == ring->capacity) {
+            return 0;
+        }
+    }
+
+    ring->slots[tail & ring->mask] = item;
+    if (ring->latency != NULL) {
+        ring->stamps[tail & ring->mask] = latency_recorder_now(ring->latency);
+    }
+
+    // publish the item to the consumer
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    wait_parker_notify(&ring->not_empty, 1);
+    if (ring->events != NULL) {
+        event_notifier_signal(ring->events);
+    }
+    return 1;
+}
+
+int spsc_ring_try_pop(spsc_ring_t *ring, long double *item) {
+    // only the consumer writes head, so a relaxed load of our own index is enough
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // only look at the producer's line when our copy of tail says the ring is empty, acquire pairs with the
+    // release in try_push so the item is visible before we read it
+    if (head == ring->cached_tail) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->cached_tail) {
+            return 0;
+        }
+    }
+
+    *item = ring->slots[head & ring->mask];
+    if (ring->latency != NULL) {
+        latency_recorder_record(ring->latency,
+                                latency_recorder_elapsed(ring->latency, ring->stamps[head & ring->mask]));
+    }
+
+    // hand the slot back to the producer
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    wait_parker_notify(&ring->not_full, 1);
+    return 1;
+}
+
+/***
+ * Wait condition that appends the item of an item context once there is room
+ * @param context the item context
+ * @return 1 if the item was appended, 0 otherwise
+ */
+static int push_condition(void *context) {
+    item_context_t *push = (item_context_t *) context;
+    return spsc_ring_try_push(push->ring, *push->item);
+}
+
+/***
+ * Wait condition that removes an item into an item context once there is one
+ * @param context the item context
+ * @return 1 if an item was removed, 0 otherwise
+ */
+static int pop_condition(void *context) {
+    item_context_t *pop = (item_context_t *) context;
+    return spsc_ring_try_pop(pop->ring, pop->item);
+}
+
+void spsc_ring_push(spsc_ring_t *ring, long double item) {
+    item_context_t context = {ring, &item};
+
+    if (!spsc_ring_try_push(ring, item)) {
+        wait_strategy_wait(&ring->not_full, &ring->producer_statistics, push_condition, &context);
+    }
+}
+
+long double spsc_ring_pop(spsc_ring_t *ring) {
+    long double item;
+    item_context_t context = {ring, &item};
+
+    if (!spsc_ring_try_pop(ring, &item)) {
+        wait_strategy_wait(&ring->not_empty, &ring->consumer_statistics, pop_condition, &context);
+    }
+    return item;
+}
+
+int spsc_ring_timed_push(spsc_ring_t *ring, long double item, const struct timespec *deadline) {
+    item_context_t context = {ring, &item};
+
+    if (spsc_ring_try_push(ring, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&ring->not_full, &ring->producer_statistics, push_condition, &context, deadline);
+}
+
+int spsc_ring_timed_pop(spsc_ring_t *ring, long double *item, const struct timespec *deadline) {
+    item_context_t context = {ring, item};
+
+    if (spsc_ring_try_pop(ring, item)) {
+        return 0;
+    }
+    return wait_strategy_wait_until(&ring->not_empty, &ring->consumer_statistics, pop_condition, &context, deadline);
+}
+
+/***
+ * Copy items into the slots starting at an index, splitting the copy where the storage wraps around
+ * @param ring the ring to copy into
+ * @param index the index of the first slot
+ * @param items the items to copy
+ * @param count the number of items to copy
+ */
+static void copy_into_slots(spsc_ring_t *ring, size_t index, const long double *items, size_t count) {
+    size_t offset = index & ring->mask;
+    size_t first = ring->mask + 1 - offset;
+
+    if (first > count) {
+        first = count;
+    }
+    memcpy(&ring->slots[offset], items, sizeof(long double) * first);
+    memcpy(ring->slots, items + first, sizeof(long double) * (count - first));
+}
+
+/***
+ * Copy items out of the slots starting at an index, splitting the copy where the storage wraps around
+ * @param ring the ring to copy from
+ * @param index the index of the first slot
+ * @param items location where the items are stored
+ * @param count the number of items to copy
+ */
+static void copy_from_slots(spsc_ring_t *ring, size_t index, long double *items, size_t count) {
+    size_t offset = index & ring->mask;
+    size_t first = ring->mask + 1 - offset;
+
+    if (first > count) {
+        first = count;
+    }
+    memcpy(items, &ring->slots[offset], sizeof(long double) * first);
+    memcpy(items + first, ring->slots, sizeof(long double) * (count - first));
+}
+
+/***
+ * Stamp a run of slots that is published together with the same time
+ * @param ring the ring
+ * @param index the index of the first slot
+ * @param count the number of slots
+ */
+static void stamp_slots(spsc_ring_t *ring, size_t index, size_t count) {
+    uint64_t now = latency_recorder_now(ring->latency);
+    size_t end = index + count;
+
+    for (; index != end; index++) {
+        ring->stamps[index & ring->mask] = now;
+    }
+}
+
+/***
+ * Record the latency of every slot in a run that is consumed together
+ * @param ring the ring
+ * @param index the index of the first slot
+ * @param count the number of slots
+ */
+static void record_slots(spsc_ring_t *ring, size_t index, size_t count) {
+    size_t end = index + count;
+
+    for (; index != end; index++) {
+        latency_recorder_record(ring->latency,
+                                latency_recorder_elapsed(ring->latency, ring->stamps[index & ring->mask]));
+    }
+}
+
+size_t spsc_ring_try_push_batch(spsc_ring_t *ring, const long double *items, size_t count) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t free_slots = ring->capacity - (tail - ring->cached_head);
+
+    // only look at the consumer's line when our copy of head does not leave room for the whole batch
+    if (count > free_slots) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        free_slots = ring->capacity - (tail - ring->cached_head);
+        if (count > free_slots) {
+            count = free_slots;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    copy_into_slots(ring, tail, items, count);
+    if (ring->latency != NULL) {
+        stamp_slots(ring, tail, count);
+    }
+
+    // publish the whole run to the consumer at once
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    wait_parker_notify(&ring->not_empty, 1);
+    if (ring->events != NULL) {
+        event_notifier_signal(ring->events);
+    }
+    return count;
+}
+
+size_t spsc_ring_try_pop_batch(spsc_ring_t *ring, long double *items, size_t count) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t available = ring->cached_tail - head;
+
+    // only look at the producer's line when our copy of tail does not cover the whole batch
+    if (count > available) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        available = ring->cached_tail - head;
+        if (count > available) {
+            count = available;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    copy_from_slots(ring, head, items, count);
+    if (ring->latency != NULL) {
+        record_slots(ring, head, count);
+    }
+
+    // hand the whole run back to the producer at once
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+    wait_parker_notify(&ring->not_full, 1);
+    return count;
+}
+
+/***
+ * Wait condition that appends the remaining items of a batch context once there is room for some of them
+ * @param context the batch context
+ * @return 1 if any items were appended, 0 otherwise
+ */
+static int push_batch_condition(void *context) {
+    batch_context_t *push = (batch_context_t *) context;
+    size_t pushed = spsc_ring_try_push_batch(push->ring, push->items + push->done, push->count - push->done);
+    push->done += pushed;
+    return pushed > 0;
+}
+
+/***
+ * Wait condition that removes the available items into a batch context once there are some
+ * @param context the batch context
+ * @return 1 if any items were removed, 0 otherwise
+ */
+static int pop_batch_condition(void *context) {
+    batch_context_t *pop = (batch_context_t *) context;
+    pop->done = spsc_ring_try_pop_batch(pop->ring, pop->items, pop->count);
+    return pop->done > 0;
+}
+
+void spsc_ring_push_batch(spsc_ring_t *ring, const long double *items, size_t count) {
+    batch_context_t context = {ring, (long double *) items, count, 0};
+
+    context.done = spsc_ring_try_push_batch(ring, items, count);
+    while (context.done < count) {
+        wait_strategy_wait(&ring->not_full, &ring->producer_statistics, push_batch_condition, &context);
+    }
+}
+
+size_t spsc_ring_pop_batch(spsc_ring_t *ring, long double *items, size_t count) {
+    batch_context_t context = {ring, items, count, 0};
+
+    if (count == 0) {
+        return 0;
+    }
+
+    context.done = spsc_ring_try_pop_batch(ring, items, count);
+    if (context.done == 0) {
+        wait_strategy_wait(&ring->not_empty, &ring->consumer_statistics, pop_batch_condition, &context);
+    }
+    return context.done;
+}
@@ -0,0 +1,182 @@
+/***
+ * Lock-free single-producer/single-consumer ring buffer
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * The ring keeps the bounded semantics of the empty/full semaphore pair: the producer may only write when
+ * fewer than capacity items are outstanding and the consumer may only read when at least one item is
+ * outstanding. Both conditions are derived from two monotonically increasing indices that are published with
+ * release stores and observed with acquire loads, so no kernel object is touched on the fast path.
+ *
+ * The indices never wrap back to zero, the slot for an index is found by masking it with the storage size,
+ * which is the capacity rounded up to a power of two. The ring can therefore carry an unbounded stream of
+ * items with constant memory.
+ *
+ * The batch operations reserve up to count slots with a single acquire load, copy the items in or out and
+ * publish the whole run with a single release store, which amortizes the synchronization over many items.
+ *
+ * The blocking operations wait with the wait strategy, the producer parks on not_full and the consumer parks on
+ * not_empty.
+ *
+ * The control block is split into cache lines by owner: the read-only description of the storage, the producer's
+ * tail, the consumer's head and each parker live on separate lines. The producer also keeps a private copy of
+ * head and only reloads it when the copy says the ring is full, and the consumer does the same with tail, so in
+ * steady state each side reads the other side's line once per lap instead of once per item.
+ *
+ * When latency recording is enabled every slot is stamped when it is published and the consumer records the time
+ * the item spent in the ring; when it is disabled the only cost is a test of a read-only pointer.
+ *
+ * The slots are mapped with the buffer memory policy, which chooses their page size and NUMA node.
+ */
+
+#ifndef BOUNDED_BUFFER_SPSC_RING_H
+#define BOUNDED_BUFFER_SPSC_RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "cache_line.h"
+#include "event_notifier.h"
+#include "latency_histogram.h"
+#include "wait_strategy.h"
+
+/***
+ * The ring buffer, the producer owns tail and cached_head and the consumer owns head and cached_tail
+ */
+typedef struct spsc_ring {
+    CACHE_LINE_ALIGNED long double *slots;
+    size_t capacity;
+    size_t mask;
+    uint64_t *stamps;
+    latency_recorder_t *latency;
+    event_notifier_t *events;
+
+    CACHE_LINE_ALIGNED atomic_size_t tail;
+    size_t cached_head;
+    wait_statistics_t producer_statistics;
+
+    CACHE_LINE_ALIGNED atomic_size_t head;
+    size_t cached_tail;
+    wait_statistics_t consumer_statistics;
+
+    CACHE_LINE_ALIGNED wait_parker_t not_full;
+    CACHE_LINE_ALIGNED wait_parker_t not_empty;
+} spsc_ring_t;
+
+/***
+ * Initialize the ring and allocate storage for its slots
+ * @param ring the ring to initialize
+ * @param capacity the maximum number of items the ring can hold, storage is rounded up to a power of two
+ * @return 0 on success, an error number otherwise
+ */
+int spsc_ring_init(spsc_ring_t *ring, size_t capacity);
+
+/***
+ * Stamp every item when it is published and record its latency when it is consumed, must be called before the
+ * ring is used
+ * @param ring the ring
+ * @param recorder the recorder the consumer records latencies into
+ * @return 0 on success, an error number otherwise
+ */
+int spsc_ring_enable_latency(spsc_ring_t *ring, latency_recorder_t *recorder);
+
+/***
+ * Write the eventfd of a notifier whenever the ring turns non-empty while the notifier is armed, so that the consumer
+ * can wait for items in epoll, must be called before the ring is used
+ * @param ring the ring
+ * @param notifier the notifier the consumer arms
+ */
+void spsc_ring_enable_events(spsc_ring_t *ring, event_notifier_t *notifier);
+
+/***
+ * Release the storage held by the ring
+ * @param ring the ring to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int spsc_ring_destroy(spsc_ring_t *ring);
+
+/***
+ * Append an item to the ring without waiting, must only be called from the producer thread
+ * @param ring the ring to append to
+ * @param item the item to append
+ * @return 1 if the item was appended, 0 if the ring was full
+ */
+int spsc_ring_try_push(spsc_ring_t *ring, long double item);
+
+/***
+ * Remove the oldest item from the ring without waiting, must only be called from the consumer thread
+ * @param ring the ring to remove from
+ * @param item location where the removed item is stored
+ * @return 1 if an item was removed, 0 if the ring was empty
+ */
+int spsc_ring_try_pop(spsc_ring_t *ring, long double *item);
+
+/***
+ * Append an item to the ring, waiting while the ring is full (equivalent of sem_wait on the empty semaphore)
+ * @param ring the ring to append to
+ * @param item the item to append
+ */
+void spsc_ring_push(spsc_ring_t *ring, long double item);
+
+/***
+ * Remove the oldest item from the ring, waiting while the ring is empty (equivalent of sem_wait on the full
+ * semaphore)
+ * @param ring the ring to remove from
+ * @return the removed item
+ */
+long double spsc_ring_pop(spsc_ring_t *ring);
+
+/***
+ * Append an item, waiting while the ring is full but no longer than until a deadline
+ * @param ring the ring to append to
+ * @param item the item to append
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if the item was appended, ETIMEDOUT if the deadline passed first
+ */
+int spsc_ring_timed_push(spsc_ring_t *ring, long double item, const struct timespec *deadline);
+
+/***
+ * Remove an item, waiting while the ring is empty but no longer than until a deadline
+ * @param ring the ring to remove from
+ * @param item location where the removed item is stored
+ * @param deadline the time on CLOCK_MONOTONIC to give up at
+ * @return 0 if an item was removed, ETIMEDOUT if the deadline passed first
+ */
+int spsc_ring_timed_pop(spsc_ring_t *ring, long double *item, const struct timespec *deadline);
+
+/***
+ * Append as many items as currently fit without waiting, must only be called from the producer thread
+ * @param ring the ring to append to
+ * @param items the items to append
+ * @param count the number of items to append
+ * @return the number of items appended, from 0 to count
+ */
+size_t spsc_ring_try_push_batch(spsc_ring_t *ring, const long double *items, size_t count);
+
+/***
+ * Remove as many items as are currently available without waiting, must only be called from the consumer thread
+ * @param ring the ring to remove from
+ * @param items location where the removed items are stored
+ * @param count the maximum number of items to remove
+ * @return the number of items removed, from 0 to count
+ */
+size_t spsc_ring_try_pop_batch(spsc_ring_t *ring, long double *items, size_t count);
+
+/***
+ * Append all items to the ring, waiting while the ring is full and publishing each run that fits at once
+ * @param ring the ring to append to
+ * @param items the items to append
+ * @param count the number of items to append
+ */
+void spsc_ring_push_batch(spsc_ring_t *ring, const long double *items, size_t count);
+
+/***
+ * Remove every item that is available up to count, waiting while the ring is empty
+ * @param ring the ring to remove from
+ * @param items location where the removed items are stored
+ * @param count the maximum number of items to remove
+ * @return the number of items removed, at least 1 unless count is 0
+ */
+size_t spsc_ring_pop_batch(spsc_ring_t *ring, long double *items, size_t count);
+
+#endif //BOUNDED_BUFFER_SPSC_RING_H
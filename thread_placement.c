@@ -0,0 +1,288 @@
+/***
+ * CPU affinity and scheduling policy of the worker threads
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "thread_placement.h"
+
+#define MAX_CACHE_INDEX 16
+
+/***
+ * A CPU and where it sits in the topology: the lowest CPU of its last level cache domain and its position among the
+ * hardware threads of its core
+ */
+typedef struct cpu_place {
+    int cpu;
+    int cache;
+    int sibling;
+} cpu_place_t;
+
+int thread_placement_parse_schedule(const char *text, thread_schedule_t *schedule) {
+    char *end;
+    long priority;
+
+    if (strcmp(text, "other") == 0) {
+        schedule->policy = SCHED_OTHER;
+        schedule->priority = 0;
+        return 0;
+    }
+    if (strncmp(text, "fifo:", 5) != 0) {
+        return EINVAL;
+    }
+
+    priority = strtol(text + 5, &end, 10);
+    if (end == text + 5 || *end != '\0' || priority < sched_get_priority_min(SCHED_FIFO) ||
+        priority > sched_get_priority_max(SCHED_FIFO)) {
+        return EINVAL;
+    }
+    schedule->policy = SCHED_FIFO;
+    schedule->priority = (int) priority;
+    return 0;
+}
+
+int thread_placement_parse_cpus(const char *list, int *cpus, int max_count, int *count) {
+    const char *position = list;
+    char *end;
+    long first, last, cpu;
+
+    *count = 0;
+    while (*position != '\0' && *position != '\n') {
+        first = strtol(position, &end, 10);
+        if (end == position || first < 0) {
+            return EINVAL;
+        }
+        last = first;
+        if (*end == '-') {
+            position = end + 1;
+            last = strtol(position, &end, 10);
+            if (end == position || last < first) {
+                return EINVAL;
+            }
+        }
+        for (cpu = first; cpu <= last; cpu++) {
+            if (*count == max_count || cpu >= CPU_SETSIZE) {
+                return EINVAL;
+            }
+            cpus[(*count)++] = (int) cpu;
+        }
+
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0' && *end != '\n') {
+            return EINVAL;
+        }
+        position = end;
+    }
+    return (*count > 0) ? 0 : EINVAL;
+}
+
+/***
+ * Read the first line of a sysfs file
+ * @param path the path of the file
+ * @param line location where the line is stored
+ * @param size the size of line
+ * @return 0 on success, an error number otherwise
+ */
+static int read_line(const char *path, char *line, size_t size) {
+    FILE *file = fopen(path, "r");
+    int error_code = 0;
+
+    if (file == NULL) {
+        return errno;
+    }
+    if (fgets(line, (int) size, file) == NULL) {
+        error_code = EIO;
+    }
+    fclose(file);
+    return error_code;
+}
+
+/***
+ * Find the lowest CPU that shares the last level cache of a CPU
+ * @param cpu the CPU
+ * @return the lowest CPU of the domain, 0 if the cache topology is not known
+ */
+static int cache_domain(int cpu) {
+    char path[128], line[4096];
+    int index, level, highest_level = 0, domain = 0, first;
+
+    for (index = 0; index < MAX_CACHE_INDEX; index++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, index);
+        if (read_line(path, line, sizeof(line)) != 0) {
+            break;
+        }
+        if (strncmp(line, "Instruction", 11) == 0) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+        if (read_line(path, line, sizeof(line)) != 0 || sscanf(line, "%d", &level) != 1 || level <= highest_level) {
+            continue;
+        }
+
+        // the list is sorted, so its first CPU names the domain
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+        if (read_line(path, line, sizeof(line)) == 0 && sscanf(line, "%d", &first) == 1) {
+            highest_level = level;
+            domain = first;
+        }
+    }
+    return domain;
+}
+
+/***
+ * Find the position of a CPU among the hardware threads of its core
+ * @param cpu the CPU
+ * @return 0 for the first hardware thread of the core or if the core topology is not known, 1 for the second
+ */
+static int sibling_rank(int cpu) {
+    char path[128], line[4096];
+    int siblings[CPU_SETSIZE], count, rank;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    if (read_line(path, line, sizeof(line)) != 0 ||
+        thread_placement_parse_cpus(line, siblings, CPU_SETSIZE, &count) != 0) {
+        return 0;
+    }
+    rank = 0;
+    while (rank < count && siblings[rank] != cpu) {
+        rank++;
+    }
+    return (rank < count) ? rank : 0;
+}
+
+/***
+ * Compare two CPUs for the placement order: by cache domain, then by hardware thread, then by number
+ * @param first the first CPU
+ * @param second the second CPU
+ * @return negative, zero or positive like strcmp
+ */
+static int compare_places(const void *first, const void *second) {
+    const cpu_place_t *a = (const cpu_place_t *) first, *b = (const cpu_place_t *) second;
+
+    if (a->cache != b->cache) {
+        return (a->cache > b->cache) - (a->cache < b->cache);
+    }
+    if (a->sibling != b->sibling) {
+        return (a->sibling > b->sibling) - (a->sibling < b->sibling);
+    }
+    return (a->cpu > b->cpu) - (a->cpu < b->cpu);
+}
+
+int thread_placement_default(int *cpus, int producer_count, int consumer_count) {
+    cpu_set_t allowed;
+    cpu_place_t *places;
+    int cpu, count = 0, pair, slot = 0;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return errno;
+    }
+    places = (cpu_place_t *) malloc(sizeof(cpu_place_t) * CPU_COUNT(&allowed));
+    if (places == NULL) {
+        return ENOMEM;
+    }
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            places[count].cpu = cpu;
+            places[count].cache = cache_domain(cpu);
+            places[count].sibling = sibling_rank(cpu);
+            count++;
+        }
+    }
+    qsort(places, count, sizeof(cpu_place_t), compare_places);
+
+    // producer i and consumer i take consecutive places, and threads share CPUs once every CPU has one
+    for (pair = 0; pair < producer_count || pair < consumer_count; pair++) {
+        if (pair < producer_count) {
+            cpus[pair] = places[slot++ % count].cpu;
+        }
+        if (pair < consumer_count) {
+            cpus[producer_count + pair] = places[slot++ % count].cpu;
+        }
+    }
+
+    free(places);
+    return 0;
+}
+
+int thread_placement_node(int cpu) {
+    char path[64];
+    struct dirent *entry;
+    DIR *directory;
+    int node = -1;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    directory = opendir(path);
+    if (directory == NULL) {
+        return -1;
+    }
+    while ((entry = readdir(directory)) != NULL) {
+        if (sscanf(entry->d_name, "node%d", &node) == 1) {
+            break;
+        }
+        node = -1;
+    }
+    closedir(directory);
+    return node;
+}
+
+int thread_placement_configure_attr(pthread_attr_t *attr, int cpu, const thread_schedule_t *schedule) {
+    struct sched_param parameter;
+    cpu_set_t set;
+    int error_code;
+
+    if (cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        error_code = pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+        if (error_code != 0) {
+            return error_code;
+        }
+    }
+
+    if (schedule->policy >= 0) {
+        // without an explicit schedule the attributes are ignored in favour of the creating thread's policy
+        error_code = pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+        if (error_code == 0) {
+            error_code = pthread_attr_setschedpolicy(attr, schedule->policy);
+        }
+        if (error_code == 0) {
+            parameter.sched_priority = schedule->priority;
+            error_code = pthread_attr_setschedparam(attr, &parameter);
+        }
+        return error_code;
+    }
+    return 0;
+}
+
+int thread_placement_configure_self(int cpu, const thread_schedule_t *schedule) {
+    struct sched_param parameter;
+    cpu_set_t set;
+    int error_code;
+
+    if (cpu >= 0) {
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        error_code = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (error_code != 0) {
+            return error_code;
+        }
+    }
+
+    if (schedule->policy >= 0) {
+        parameter.sched_priority = schedule->priority;
+        return pthread_setschedparam(pthread_self(), schedule->policy, &parameter);
+    }
+    return 0;
+}
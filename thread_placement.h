@@ -0,0 +1,84 @@
+/***
+ * CPU affinity and scheduling policy of the worker threads
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * A producer and a consumer hand every item over through the cache lines of the buffer, so where the scheduler
+ * runs them decides what a handoff costs: on two hardware threads of one core they compete for the core, on cores
+ * that share a last level cache a line moves between their private caches, and on different sockets it crosses
+ * the interconnect. The scheduler may also migrate a spinning thread at any time.
+ *
+ * The default placement reads the cache topology from sysfs, restricted to the CPUs the process may run on, and
+ * orders the CPUs so that each last level cache domain lists one hardware thread of each of its cores before the
+ * second hardware threads. Producer i and consumer i take consecutive places in that order, so every pair shares
+ * a last level cache on separate cores for as long as the domain has free cores.
+ *
+ * The placement and the scheduling policy are applied through the attributes a thread is created with, or to the
+ * calling thread for a worker that runs in a process of its own.
+ */
+
+#ifndef BOUNDED_BUFFER_THREAD_PLACEMENT_H
+#define BOUNDED_BUFFER_THREAD_PLACEMENT_H
+
+#include <pthread.h>
+
+/***
+ * The scheduling policy of a thread, a policy of -1 inherits the policy of the creating thread
+ */
+typedef struct thread_schedule {
+    int policy;
+    int priority;
+} thread_schedule_t;
+
+/***
+ * Parse a scheduling policy, other for SCHED_OTHER or fifo:priority for SCHED_FIFO
+ * @param text the policy to parse
+ * @param schedule location where the policy is stored
+ * @return 0 on success, EINVAL if the policy or the priority is not valid
+ */
+int thread_placement_parse_schedule(const char *text, thread_schedule_t *schedule);
+
+/***
+ * Parse a comma separated list of CPUs and CPU ranges such as 0,2,4-7
+ * @param list the list to parse
+ * @param cpus location where the CPUs are stored in order
+ * @param max_count the number of CPUs cpus can hold
+ * @param count location where the number of CPUs is stored
+ * @return 0 on success, EINVAL if the list is not valid or too long
+ */
+int thread_placement_parse_cpus(const char *list, int *cpus, int max_count, int *count);
+
+/***
+ * Place producers and consumers on the topology of the machine, producer i next to consumer i
+ * @param cpus location where the CPUs of the producers followed by those of the consumers are stored
+ * @param producer_count the number of producers
+ * @param consumer_count the number of consumers
+ * @return 0 on success, an error number otherwise
+ */
+int thread_placement_default(int *cpus, int producer_count, int consumer_count);
+
+/***
+ * Get the NUMA node of a CPU
+ * @param cpu the CPU
+ * @return the node, -1 if it is not known
+ */
+int thread_placement_node(int cpu);
+
+/***
+ * Set the CPU and the scheduling policy of the threads created with a set of attributes
+ * @param attr the attributes
+ * @param cpu the CPU to pin the threads to, -1 to leave them unpinned
+ * @param schedule the scheduling policy
+ * @return 0 on success, an error number otherwise
+ */
+int thread_placement_configure_attr(pthread_attr_t *attr, int cpu, const thread_schedule_t *schedule);
+
+/***
+ * Set the CPU and the scheduling policy of the calling thread
+ * @param cpu the CPU to pin the thread to, -1 to leave it unpinned
+ * @param schedule the scheduling policy
+ * @return 0 on success, an error number otherwise
+ */
+int thread_placement_configure_self(int cpu, const thread_schedule_t *schedule);
+
+#endif //BOUNDED_BUFFER_THREAD_PLACEMENT_H
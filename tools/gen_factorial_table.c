@@ -0,0 +1,44 @@
+/***
+ * Generates the factorial lookup table at build time
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * Prints a header with n! for every n whose factorial is finite in long double. The products are accumulated in
+ * ascending order exactly like the recursive produce_item did, and printed as hexadecimal floating point literals
+ * so the table holds bit for bit the values the recursion computed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+/***
+ * Main function
+ * @return error code
+ */
+int main() {
+    long double value = 1;
+    unsigned int number, count;
+
+    // count the finite factorials, the first infinite one ends the table
+    for (count = 1; !isinf(value * count); count++) {
+        value *= count;
+    }
+
+    printf("/* generated by gen_factorial_table, do not edit */\n\n");
+    printf("#ifndef BOUNDED_BUFFER_FACTORIAL_TABLE_H\n");
+    printf("#define BOUNDED_BUFFER_FACTORIAL_TABLE_H\n\n");
+    printf("#define FACTORIAL_TABLE_SIZE %u\n\n", count);
+    printf("static const long double factorial_table[FACTORIAL_TABLE_SIZE] = {\n");
+
+    value = 1;
+    for (number = 0; number < count; number++) {
+        if (number > 0) {
+            value *= number;
+        }
+        printf("        %LaL,\n", value);
+    }
+
+    printf("};\n\n");
+    printf("#endif //BOUNDED_BUFFER_FACTORIAL_TABLE_H\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+/***
+ * Adaptive spin-then-park wait strategy
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "wait_strategy.h"
+
+/***
+ * The limits of the spinning and yielding phases, shared by every waiter
+ */
+static atomic_uint spin_limit = DEFAULT_SPIN_LIMIT;
+static atomic_uint yield_limit = DEFAULT_YIELD_LIMIT;
+
+/***
+ * Park the calling thread as long as the epoch of a parker still holds the expected value
+ * @param parker the parker
+ * @param expected the value the kernel compares the epoch against before parking
+ * @param deadline the time on CLOCK_MONOTONIC the kernel wakes us at, NULL to park until notified
+ */
+static void futex_wait(wait_parker_t *parker, unsigned int expected, const struct timespec *deadline) {
+    if (deadline == NULL) {
+        syscall(SYS_futex, &parker->epoch, parker->process_shared ? FUTEX_WAIT : FUTEX_WAIT_PRIVATE, expected, NULL,
+                NULL, 0);
+        return;
+    }
+
+    // unlike FUTEX_WAIT, the bitset variant takes an absolute timeout, measured on CLOCK_MONOTONIC by default
+    syscall(SYS_futex, &parker->epoch, parker->process_shared ? FUTEX_WAIT_BITSET : FUTEX_WAIT_BITSET_PRIVATE,
+            expected, deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+}
+
+/***
+ * Check if a deadline has passed
+ * @param deadline the time on CLOCK_MONOTONIC, NULL for no deadline
+ * @return 1 if the deadline has passed, 0 otherwise
+ */
+static int deadline_passed(const struct timespec *deadline) {
+    struct timespec now;
+
+    if (deadline == NULL) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+/***
+ * Wake threads parked on the epoch of a parker
+ * @param parker the parker
+ * @param count the maximum number of threads to wake
+ */
+static void futex_wake(wait_parker_t *parker, int count) {
+    syscall(SYS_futex, &parker->epoch, parker->process_shared ? FUTEX_WAKE : FUTEX_WAKE_PRIVATE, count, NULL, NULL,
+            0);
+}
+
+void wait_strategy_configure(unsigned int spin, unsigned int yield) {
+    atomic_store_explicit(&spin_limit, spin, memory_order_relaxed);
+    atomic_store_explicit(&yield_limit, yield, memory_order_relaxed);
+}
+
+void wait_parker_init(wait_parker_t *parker) {
+    atomic_init(&parker->epoch, 0);
+    atomic_init(&parker->waiters, 0);
+    parker->process_shared = 0;
+}
+
+void wait_parker_init_shared(wait_parker_t *parker) {
+    wait_parker_init(parker);
+    parker->process_shared = 1;
+}
+
+void wait_parker_notify(wait_parker_t *parker, int count) {
+    // orders the store that made the condition true before the load of waiters, pairs with the fence in
+    // wait_strategy_wait so that either the waiter sees the condition or we see the waiter
+    atomic_thread_fence(memory_order_seq_cst);
+
+    // only enter the kernel if somebody may be parked
+    if (atomic_load_explicit(&parker->waiters, memory_order_relaxed) > 0) {
+        atomic_fetch_add(&parker->epoch, 1);
+        futex_wake(parker, count);
+    }
+}
+
+void wait_statistics_init(wait_statistics_t *statistics) {
+    atomic_init(&statistics->spin, 0);
+    atomic_init(&statistics->yield, 0);
+    atomic_init(&statistics->park, 0);
+    atomic_init(&statistics->timeout, 0);
+}
+
+void wait_statistics_print(const char *name, wait_statistics_t *statistics) {
+    printf("%s waits resolved by spinning %llu, yielding %llu, parking %llu\n", name,
+           atomic_load(&statistics->spin), atomic_load(&statistics->yield), atomic_load(&statistics->park));
+
+    // only waits with a deadline can time out, so the line is left out when nobody used one
+    if (atomic_load(&statistics->timeout) > 0) {
+        printf("%s waits timed out %llu times\n", name, atomic_load(&statistics->timeout));
+    }
+}
+
+void wait_deadline_after(struct timespec *deadline, uint64_t nanoseconds) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    nanoseconds += (uint64_t) deadline->tv_nsec;
+    deadline->tv_sec += (time_t) (nanoseconds / 1000000000ULL);
+    deadline->tv_nsec = (long) (nanoseconds % 1000000000ULL);
+}
+
+void wait_strategy_wait(wait_parker_t *parker, wait_statistics_t *statistics, wait_condition_t condition,
+                        void *context) {
+    wait_strategy_wait_until(parker, statistics, condition, context, NULL);
+}
+
+int wait_strategy_wait_until(wait_parker_t *parker, wait_statistics_t *statistics, wait_condition_t condition,
+                             void *context, const struct timespec *deadline) {
+    unsigned int iteration;
+    unsigned int spins = atomic_load_explicit(&spin_limit, memory_order_relaxed);
+    unsigned int yields = atomic_load_explicit(&yield_limit, memory_order_relaxed);
+
+    // spin, the condition is likely to become true within a few hundred cycles
+    for (iteration = 0; iteration < spins; iteration++) {
+        cpu_relax();
+        if (condition(context)) {
+            atomic_fetch_add_explicit(&statistics->spin, 1, memory_order_relaxed);
+            return 0;
+        }
+    }
+
+    // yield, give the thread that makes the condition true a chance to run on this core
+    for (iteration = 0; iteration < yields; iteration++) {
+        sched_yield();
+        if (condition(context)) {
+            atomic_fetch_add_explicit(&statistics->yield, 1, memory_order_relaxed);
+            return 0;
+        }
+        if (deadline_passed(deadline)) {
+            atomic_fetch_add_explicit(&statistics->timeout, 1, memory_order_relaxed);
+            return ETIMEDOUT;
+        }
+    }
+
+    // park, the epoch is read before announcing ourselves so a notification after the final check changes it
+    // and the kernel refuses to park us
+    for (;;) {
+        unsigned int epoch = atomic_load(&parker->epoch);
+        atomic_fetch_add(&parker->waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        if (condition(context)) {
+            atomic_fetch_sub(&parker->waiters, 1);
+            break;
+        }
+
+        // checked after the condition so that a condition that became true just in time still succeeds
+        if (deadline_passed(deadline)) {
+            atomic_fetch_sub(&parker->waiters, 1);
+            atomic_fetch_add_explicit(&statistics->timeout, 1, memory_order_relaxed);
+            return ETIMEDOUT;
+        }
+
+        futex_wait(parker, epoch, deadline);
+        atomic_fetch_sub(&parker->waiters, 1);
+    }
+    atomic_fetch_add_explicit(&statistics->park, 1, memory_order_relaxed);
+    return 0;
+}
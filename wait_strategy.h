@@ -0,0 +1,135 @@
+/***
+ * Adaptive spin-then-park wait strategy
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * A thread that has to wait for a condition first spins with a pause instruction, then yields the processor and
+ * finally parks on a futex. The first two phases catch conditions that become true within microseconds without
+ * paying for a context switch, the last phase keeps a thread that waits for long from burning a core. The limits
+ * for each phase are process wide and can be changed at any time, and every wait records which phase resolved it.
+ *
+ * A thread that makes a condition true must call wait_parker_notify on the parker the waiters use, the call only
+ * enters the kernel when a thread is actually parked.
+ *
+ * A wait can be bounded by a deadline on CLOCK_MONOTONIC, which does not jump when the wall clock is set. The
+ * yielding and parking phases give up once it has passed, and a parked thread is woken by the kernel at the
+ * deadline, so a caller can shed or reroute work instead of stalling.
+ */
+
+#ifndef BOUNDED_BUFFER_WAIT_STRATEGY_H
+#define BOUNDED_BUFFER_WAIT_STRATEGY_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+#define DEFAULT_SPIN_LIMIT 256
+#define DEFAULT_YIELD_LIMIT 16
+
+/***
+ * The futex word waiters park on and the number of threads that may be parked on it, process_shared selects
+ * futex operations that work across processes mapping the parker
+ */
+typedef struct wait_parker {
+    atomic_uint epoch;
+    atomic_int waiters;
+    int process_shared;
+} wait_parker_t;
+
+/***
+ * The number of waits resolved in each phase and the number of waits that reached their deadline
+ */
+typedef struct wait_statistics {
+    atomic_ullong spin;
+    atomic_ullong yield;
+    atomic_ullong park;
+    atomic_ullong timeout;
+} wait_statistics_t;
+
+/***
+ * A condition to wait for, it is evaluated repeatedly and may perform the awaited operation when it succeeds
+ * @param context the context passed to wait_strategy_wait
+ * @return non-zero once the condition is true
+ */
+typedef int (*wait_condition_t)(void *context);
+
+/***
+ * Hint to the processor that the calling thread is spinning
+ */
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/***
+ * Change the number of iterations of the spinning and yielding phases
+ * @param spin_limit number of pause iterations before the waiter starts yielding
+ * @param yield_limit number of yields before the waiter parks
+ */
+void wait_strategy_configure(unsigned int spin_limit, unsigned int yield_limit);
+
+/***
+ * Initialize a parker
+ * @param parker the parker to initialize
+ */
+void wait_parker_init(wait_parker_t *parker);
+
+/***
+ * Initialize a parker that lives in shared memory and is used by threads of several processes
+ * @param parker the parker to initialize
+ */
+void wait_parker_init_shared(wait_parker_t *parker);
+
+/***
+ * Wake threads parked on a parker, must be called after the condition they wait for was made true
+ * @param parker the parker to notify
+ * @param count the maximum number of threads to wake
+ */
+void wait_parker_notify(wait_parker_t *parker, int count);
+
+/***
+ * Initialize the statistics of a waiter
+ * @param statistics the statistics to initialize
+ */
+void wait_statistics_init(wait_statistics_t *statistics);
+
+/***
+ * Print the statistics of a waiter
+ * @param name the name of the waiter
+ * @param statistics the statistics to print
+ */
+void wait_statistics_print(const char *name, wait_statistics_t *statistics);
+
+/***
+ * Wait until a condition is true, spinning, then yielding and finally parking
+ * @param parker the parker the thread parks on, notified whenever the condition may have become true
+ * @param statistics the statistics to record the resolving phase in
+ * @param condition the condition to wait for
+ * @param context the context passed to the condition
+ */
+void wait_strategy_wait(wait_parker_t *parker, wait_statistics_t *statistics, wait_condition_t condition,
+                        void *context);
+
+/***
+ * Wait until a condition is true or a deadline has passed, spinning, then yielding and finally parking
+ * @param parker the parker the thread parks on, notified whenever the condition may have become true
+ * @param statistics the statistics to record the resolving phase or the timeout in
+ * @param condition the condition to wait for
+ * @param context the context passed to the condition
+ * @param deadline the time on CLOCK_MONOTONIC to give up at, NULL to wait for as long as it takes
+ * @return 0 once the condition is true, ETIMEDOUT if the deadline passed first
+ */
+int wait_strategy_wait_until(wait_parker_t *parker, wait_statistics_t *statistics, wait_condition_t condition,
+                             void *context, const struct timespec *deadline);
+
+/***
+ * Compute a deadline on CLOCK_MONOTONIC
+ * @param deadline location where the deadline is stored
+ * @param nanoseconds the time from now to the deadline
+ */
+void wait_deadline_after(struct timespec *deadline, uint64_t nanoseconds);
+
+#endif //BOUNDED_BUFFER_WAIT_STRATEGY_H
@@ -0,0 +1,180 @@
+/***
+ * Work-stealing pool of consumers with a bounded deque per worker
+ * @anchor Lalit Adithya
+ * @version 1.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "ring_math.h"
+#include "work_pool.h"
+
+int work_pool_init(work_pool_t *pool, int worker_count, size_t deque_capacity) {
+    work_deque_t *deque;
+    size_t size;
+    int worker;
+
+    if (worker_count < 1 || deque_capacity == 0) {
+        return EINVAL;
+    }
+
+    // every deque starts on a cache line of its own, which malloc does not guarantee
+    pool->deques = (work_deque_t *) aligned_alloc(CACHE_LINE_SIZE, sizeof(work_deque_t) * worker_count);
+    if (pool->deques == NULL) {
+        return ENOMEM;
+    }
+
+    size = round_up_power_of_two(deque_capacity);
+    for (worker = 0; worker < worker_count; worker++) {
+        deque = &pool->deques[worker];
+        deque->slots = (long double *) malloc(sizeof(long double) * size);
+        if (deque->slots == NULL) {
+            while (--worker >= 0) {
+                free(pool->deques[worker].slots);
+            }
+            free(pool->deques);
+            pool->deques = NULL;
+            return ENOMEM;
+        }
+        deque->capacity = deque_capacity;
+        deque->mask = size - 1;
+        atomic_init(&deque->top, 0);
+        atomic_init(&deque->bottom, 0);
+    }
+
+    pool->worker_count = worker_count;
+    atomic_init(&pool->steals, 0);
+    atomic_init(&pool->stolen_items, 0);
+    wait_statistics_init(&pool->statistics);
+    wait_parker_init(&pool->work_available);
+    return 0;
+}
+
+int work_pool_destroy(work_pool_t *pool) {
+    int worker;
+
+    for (worker = 0; worker < pool->worker_count; worker++) {
+        free(pool->deques[worker].slots);
+    }
+    free(pool->deques);
+    pool->deques = NULL;
+    return 0;
+}
+
+size_t work_pool_room(work_pool_t *pool, int worker) {
+    work_deque_t *deque = &pool->deques[worker];
+
+    // only the owner writes bottom, acquire pairs with the release of the takers so they are done with the slots
+    return deque->capacity - (atomic_load_explicit(&deque->bottom, memory_order_relaxed) -
+                              atomic_load_explicit(&deque->top, memory_order_acquire));
+}
+
+int work_pool_push(work_pool_t *pool, int worker, const long double *items, size_t count) {
+    work_deque_t *deque = &pool->deques[worker];
+    size_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed), index;
+
+    if (count > work_pool_room(pool, worker)) {
+        return ENOSPC;
+    }
+
+    for (index = 0; index < count; index++) {
+        deque->slots[(bottom + index) & deque->mask] = items[index];
+    }
+
+    // publish the items to the takers and wake one idle worker to steal them, it wakes the next one if it got more
+    // than it needs
+    atomic_store_explicit(&deque->bottom, bottom + count, memory_order_release);
+    wait_parker_notify(&pool->work_available, 1);
+    return 0;
+}
+
+/***
+ * Steal half of the backlog of the busiest other worker into the empty deque of a worker
+ * @param pool the pool
+ * @param worker the index of the thief
+ * @return the number of items stolen, 0 if every other deque was empty
+ */
+static size_t steal_half(work_pool_t *pool, int worker) {
+    work_deque_t *own = &pool->deques[worker], *victim;
+    size_t top, bottom, backlog, most, count, index, own_bottom;
+    int other, busiest;
+
+    for (;;) {
+        // a racy scan is enough to pick a victim, the compare-and-swap below decides
+        busiest = -1;
+        most = 0;
+        for (other = 0; other < pool->worker_count; other++) {
+            victim = &pool->deques[other];
+            backlog = atomic_load_explicit(&victim->bottom, memory_order_relaxed) -
+                      atomic_load_explicit(&victim->top, memory_order_relaxed);
+            if (other != worker && backlog > most && backlog <= victim->capacity) {
+                busiest = other;
+                most = backlog;
+            }
+        }
+        if (busiest < 0) {
+            return 0;
+        }
+
+        // acquire pairs with the release of the owner's push so the items are visible before we copy them
+        victim = &pool->deques[busiest];
+        top = atomic_load_explicit(&victim->top, memory_order_acquire);
+        bottom = atomic_load_explicit(&victim->bottom, memory_order_acquire);
+        if (bottom - top == 0 || bottom - top > victim->capacity) {
+            continue;
+        }
+        count = (bottom - top + 1) / 2;
+        if (count > own->capacity) {
+            count = own->capacity;
+        }
+
+        // our deque is empty and nobody else writes it, so the copy lands in slots no taker can see yet
+        own_bottom = atomic_load_explicit(&own->bottom, memory_order_relaxed);
+        for (index = 0; index < count; index++) {
+            own->slots[(own_bottom + index) & own->mask] = victim->slots[(top + index) & victim->mask];
+        }
+        if (atomic_compare_exchange_strong_explicit(&victim->top, &top, top + count, memory_order_acq_rel,
+                                                    memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    atomic_store_explicit(&own->bottom, own_bottom + count, memory_order_release);
+    atomic_fetch_add_explicit(&pool->steals, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&pool->stolen_items, count, memory_order_relaxed);
+
+    // a burst spreads one worker at a time, each thief that has items to spare wakes the next one
+    if (count > 1) {
+        wait_parker_notify(&pool->work_available, 1);
+    }
+    return count;
+}
+
+int work_pool_take(work_pool_t *pool, int worker, long double *item) {
+    work_deque_t *deque = &pool->deques[worker];
+    size_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+    do {
+        // another thief may take back what we stole before we get to it, so check again after every steal
+        while (top == atomic_load_explicit(&deque->bottom, memory_order_relaxed)) {
+            if (steal_half(pool, worker) == 0) {
+                return 0;
+            }
+            top = atomic_load_explicit(&deque->top, memory_order_acquire);
+        }
+        *item = deque->slots[top & deque->mask];
+
+        // a thief may have taken the item, in which case top holds its new value and we try again
+    } while (!atomic_compare_exchange_weak_explicit(&deque->top, &top, top + 1, memory_order_acq_rel,
+                                                    memory_order_acquire));
+    return 1;
+}
+
+void work_pool_notify(work_pool_t *pool) {
+    wait_parker_notify(&pool->work_available, 1);
+}
+
+void work_pool_notify_all(work_pool_t *pool) {
+    wait_parker_notify(&pool->work_available, pool->worker_count);
+}
@@ -0,0 +1,116 @@
+/***
+ * Work-stealing pool of consumers with a bounded deque per worker
+ * @anchor Lalit Adithya
+ * @version 1.0
+ *
+ * A single consumer that falls behind backs items up into the buffer until the producer blocks. In a pool every
+ * worker moves a batch of items out of the buffer into a deque of its own and works through it, and a worker whose
+ * deque runs dry steals half of the backlog of the busiest worker, so a burst taken by one worker is spread over
+ * every worker instead of waiting for the one that took it.
+ *
+ * A deque is a bounded ring that only its owner appends to at the bottom. The owner and thieves both take from the
+ * top with a compare-and-swap, which keeps the items of a deque in order and lets a thief take half of the backlog
+ * at once: it copies the items and then moves top past all of them with one compare-and-swap, which fails if
+ * anybody took one of them in the meantime. The owner only overwrites a slot once top has moved past it, so the
+ * copy a successful thief made is never torn.
+ *
+ * Idle workers park on the pool with the wait strategy. Only one item can go to one worker, so a batch added to a
+ * deque and an item received by the buffer that feeds the pool wake a single idle worker, and a thief that stole
+ * more than one item wakes the next, which spreads a burst without waking every worker for every item. The caller
+ * wakes every worker once the pool is done.
+ */
+
+#ifndef BOUNDED_BUFFER_WORK_POOL_H
+#define BOUNDED_BUFFER_WORK_POOL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "cache_line.h"
+#include "wait_strategy.h"
+
+/***
+ * The deque of one worker, top is taken from by everybody and bottom is only written by the owner
+ */
+typedef struct work_deque {
+    CACHE_LINE_ALIGNED long double *slots;
+    size_t capacity;
+    size_t mask;
+
+    CACHE_LINE_ALIGNED atomic_size_t top;
+
+    CACHE_LINE_ALIGNED atomic_size_t bottom;
+} work_deque_t;
+
+/***
+ * The pool, the description of the deques is read-only once initialized
+ */
+typedef struct work_pool {
+    CACHE_LINE_ALIGNED work_deque_t *deques;
+    int worker_count;
+
+    CACHE_LINE_ALIGNED atomic_ullong steals;
+    atomic_ullong stolen_items;
+    wait_statistics_t statistics;
+
+    CACHE_LINE_ALIGNED wait_parker_t work_available;
+} work_pool_t;
+
+/***
+ * Initialize the pool and allocate the deques of its workers
+ * @param pool the pool to initialize
+ * @param worker_count the number of workers
+ * @param deque_capacity the maximum number of items each deque can hold, storage is rounded up to a power of two
+ * @return 0 on success, an error number otherwise
+ */
+int work_pool_init(work_pool_t *pool, int worker_count, size_t deque_capacity);
+
+/***
+ * Release the storage held by the pool
+ * @param pool the pool to destroy
+ * @return 0 on success, an error number otherwise
+ */
+int work_pool_destroy(work_pool_t *pool);
+
+/***
+ * Get the number of items a worker can add to its deque, must only be called by the worker
+ * @param pool the pool
+ * @param worker the index of the worker
+ * @return the number of free slots in the deque of the worker
+ */
+size_t work_pool_room(work_pool_t *pool, int worker);
+
+/***
+ * Add items to the bottom of the deque of a worker and wake an idle worker to steal them, must only be called by the
+ * worker
+ * @param pool the pool
+ * @param worker the index of the worker
+ * @param items the items to add
+ * @param count the number of items, at most work_pool_room
+ * @return 0 on success, ENOSPC if the deque cannot hold the items
+ */
+int work_pool_push(work_pool_t *pool, int worker, const long double *items, size_t count);
+
+/***
+ * Take an item from the deque of a worker, or when it is empty steal half of the backlog of the busiest worker into
+ * it, must only be called by the worker
+ * @param pool the pool
+ * @param worker the index of the worker
+ * @param item location where the item is stored
+ * @return 1 if an item was taken, 0 if every deque was empty
+ */
+int work_pool_take(work_pool_t *pool, int worker, long double *item);
+
+/***
+ * Wake an idle worker, called after the buffer that feeds the pool receives an item
+ * @param pool the pool
+ */
+void work_pool_notify(work_pool_t *pool);
+
+/***
+ * Wake every idle worker, called when the pool is done so that they can return
+ * @param pool the pool
+ */
+void work_pool_notify_all(work_pool_t *pool);
+
+#endif //BOUNDED_BUFFER_WORK_POOL_H